@@ -0,0 +1,16 @@
+/*
+ * clock_display.h
+ *
+ * Calculation of the alarm clock display (4 seven segment digits),
+ * the result is passed to pl_alarmclock_display().
+ */
+
+#ifndef CLOCK_DISPLAY_H_
+#define CLOCK_DISPLAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+uint32_t calc_display(uint8_t hour, uint8_t minute, bool blink, bool alarm_on, bool beep_on);
+
+#endif
@@ -40,8 +40,41 @@ void pl_init(void);
  * Processes messages sent from the virtual peripheral.
  * Needs to be called in the super loop, otherwise communication with the
  * virtual peripheral won't work.
+ * Parses everything received so far, but at most the budget set with
+ * pl_do_budget(). Returns the number of messages handled.
  */
-void pl_do();
+int pl_do();
+
+/*
+ * Sleeps until something happens: a byte from the virtual peripheral, a
+ * tick or any other interrupt. Returns at once if pl_do() has work.
+ * Call it in the super loop after the work is done, instead of spinning:
+ *   while (1) { pl_do(); ...; pl_wait_event(); }
+ * On the board the core halts (WFI), on the host the process blocks.
+ */
+void pl_wait_event();
+
+/*
+ * Limits the work of one pl_do() call to bytes received bytes and,
+ * if cycles is not 0, to about cycles CPU cycles (checked every 16 bytes).
+ * Defaults: PL_DO_BYTES, PL_DO_CYCLES in plib_config.h
+ */
+void pl_do_budget(uint16_t bytes, uint32_t cycles);
+
+/*
+ * The values of the virtual leds and displays are only stored by
+ * pl_led_set(), pl_alarmclock_display() and pl_seesaw_display(). pl_do()
+ * sends the changed ones, at most every interval ticks (counted by
+ * pl_tick(), without it at every call), as the tx buffer has room.
+ * Values written in between are overwritten, the latest one is sent.
+ * interval 0 sends at every pl_do(). Default: PL_FLUSH_TICKS in plib_config.h
+ */
+void pl_flush_interval(uint16_t interval);
+
+/*
+ * Sends all changed values now, waits for room in the tx buffer.
+ */
+void pl_flush();
 
 /*
  * Switches the user led on the real hardware on (0) or off (1)
@@ -78,12 +111,199 @@ int pl_button_get(uint8_t *buttons);
 // get value of an adc channel
 int pl_adc_get(uint8_t channel, uint16_t* value);
 
+/*
+ * Noise pl_adc_get() adds to the values of the virtual adcs, so filters
+ * in the app have something to do. amplitude is in 1/256 of an adc step,
+ * at most PL_ADC_NOISE_MAX: the half width of uniform and triangular
+ * noise, the standard deviation of gaussian noise (cut off at 3.4 times
+ * of it). Integer arithmetic only.
+ * Default: uniform with PL_ADC_NOISE_AMPLITUDE (plib_config.h).
+ * Returns -1 for an unknown distribution or too large an amplitude.
+ * With PL_ADC_DMA the values come from the real adc, without noise.
+ */
+enum pl_adc_noise_distribution {
+	PL_ADC_NOISE_NONE,
+	PL_ADC_NOISE_UNIFORM,
+	PL_ADC_NOISE_TRIANGULAR,
+	PL_ADC_NOISE_GAUSSIAN
+};
+
+#define PL_ADC_NOISE_MAX 0x3fff	// 64 adc steps
+
+int pl_adc_noise(uint8_t distribution, uint16_t amplitude);
+
+/*
+ * Input events: instead of polling the functions above, the app can be told
+ * when vPeripherals changes a switch, button or adc value. Events are
+ * delivered from pl_do(), only for actual changes.
+ */
+enum pl_event_source {
+	PL_EVENT_SWITCH,
+	PL_EVENT_BUTTON,
+	PL_EVENT_ADC,
+	PL_EVENT_SOURCES
+};
+
+typedef struct pl_event {
+	uint8_t source;		// PL_EVENT_SWITCH, PL_EVENT_BUTTON or PL_EVENT_ADC
+	uint8_t channel;	// adc channel, 0 otherwise
+	uint16_t value;		// new state, as pl_switch_get() etc. would return it
+	uint16_t previous;	// state before the change
+	uint8_t pressed;	// switches and buttons: bits that changed from 0 to 1
+	uint8_t released;	// switches and buttons: bits that changed from 1 to 0
+} pl_event;
+
+typedef void (*pl_event_handler)(const pl_event* event);
+
+/*
+ * Calls handler from pl_do() for each change of source, NULL removes it.
+ * Changes of a source without handler are queued for pl_event_get().
+ */
+int pl_event_handler_set(uint8_t source, pl_event_handler handler);
+
+/*
+ * Takes the oldest queued event. Returns 0 if there is none.
+ * The queue holds 8 events, older ones are dropped.
+ */
+int pl_event_get(pl_event* event);
+
+/*
+ * Items: vPeripherals sets an item with "d<screen><item><data>", screen
+ * '0'..'9', or "d<item><data>" for items of no screen (time, baud rate).
+ * pl_do() calls the handler registered for screen and item, looked up in
+ * a table, with the data decoded as given by type:
+ * - PL_ITEM_HEX8, PL_ITEM_HEX16, PL_ITEM_HEX32: exactly 2, 4 or 8 hex
+ *   digits, in number
+ * - PL_ITEM_DEC: 1 to 9 decimal digits, in number
+ * - PL_ITEM_TEXT: anything, not decoded
+ * Data that does not fit the type is answered with an error (e04, e05)
+ * without calling the handler. The handler returns PL_ITEM_OK or the
+ * error vPeripherals gets.
+ *
+ * plib registers the items of screen 0 (switches, buttons, adcs) and the
+ * ones of no screen ('T', 'B', 'V'). A screen module or the app adds its
+ * own, e.g. a slider on screen 2:
+ *   static int on_slider(uint8_t screen, char item, const pl_item_value *value) {
+ *       slider = value->number;
+ *       return PL_ITEM_OK;
+ *   }
+ *   pl_item_register(2, 's', PL_ITEM_HEX16, on_slider);
+ */
+#define PL_SCREEN_NONE 10	// items of no screen
+
+enum pl_item_type {
+	PL_ITEM_HEX8,
+	PL_ITEM_HEX16,
+	PL_ITEM_HEX32,
+	PL_ITEM_DEC,
+	PL_ITEM_TEXT
+};
+
+enum pl_item_result {
+	PL_ITEM_OK,
+	PL_ITEM_LENGTH,	// e04
+	PL_ITEM_DECODE,	// e05
+	PL_ITEM_VALUE	// e06
+};
+
+typedef struct pl_item_value {
+	uint32_t number;	// decoded data, not for PL_ITEM_TEXT
+	const char *text;	// the data as received, 0 terminated
+	uint8_t len;		// characters in text
+} pl_item_value;
+
+typedef int (*pl_item_handler)(uint8_t screen, char item, const pl_item_value *value);
+
+/*
+ * Registers handler for item ('0'..'9', 'A'..'Z', 'a'..'z') of screen
+ * (0..9, PL_SCREEN_NONE), replacing the one before; NULL removes it.
+ * Returns -1 for an invalid screen, item or type, or if PL_ITEMS
+ * (plib_config.h) items are registered already, 1 otherwise.
+ */
+int pl_item_register(uint8_t screen, char item, uint8_t type, pl_item_handler handler);
+
+/*
+ * Telemetry: signals sampled by the app (e.g. a control loop) are
+ * streamed to vPeripherals, which plots them. Each sample carries the
+ * values of all declared channels and its time in ticks of pl_tick().
+ * Samples are buffered (PL_TELEMETRY_BUFFER_LEN bytes) and sent by
+ * pl_do() in blocks, binary with PL_BINARY_FRAMES, hex otherwise.
+ * Samples that do not fit into the buffer are dropped and counted.
+ */
+enum pl_telemetry_type {
+	PL_TELEMETRY_INT8,
+	PL_TELEMETRY_INT16,
+	PL_TELEMETRY_UINT16,
+	PL_TELEMETRY_FLOAT
+};
+
+/*
+ * Declares channel 0, 1, ... (up to PL_TELEMETRY_CHANNELS) in this
+ * order, redeclaring a channel removes the ones after it. name must stay
+ * valid. Discards the buffered samples, call it before sampling.
+ */
+int pl_telemetry_channel(uint8_t channel, uint8_t type, const char *name);
+
+/*
+ * Keeps only every n-th sample passed to pl_telemetry_sample(), default 1.
+ */
+void pl_telemetry_decimation(uint16_t n);
+
+/*
+ * Buffers the values of all channels, converted to their types.
+ * Can be called from an interrupt handler. Returns 1 if buffered,
+ * 0 if skipped by the decimation and -1 if dropped (buffer full).
+ */
+int pl_telemetry_sample(const float *values);
+
+/*
+ * Health of the link to vPeripherals, e.g. to size PL_RX_BUFFER_LEN and
+ * PL_TX_BUFFER_LEN from data. Counters run since start, the rates cover
+ * the last full second (counted by pl_tick()) and the lowest free space
+ * the time since the previous call. vPeripherals shows the same live
+ * (option -s, requests '?Q' and '?q').
+ */
+#define PL_LINK_ERROR_CODES 6	// protocol errors e01..e06
+
+typedef struct pl_link_statistics {
+	uint32_t rx_bytes;	// received from vPeripherals
+	uint32_t tx_bytes;	// sent to vPeripherals
+	uint16_t rx_rate;	// bytes per second
+	uint16_t tx_rate;
+	uint32_t overruns;	// received bytes lost in the UART, read too late
+	uint32_t drops;		// received bytes lost because the rx buffer was full
+	uint32_t tx_waits;	// spins of a write waiting for room in the tx buffer
+	uint32_t stdout_drops;	// characters of printf() lost, see pl_stdout_write()
+	uint16_t rx_min_free;	// lowest free bytes in the rx and tx buffer,
+	uint16_t tx_min_free;	// only with PL_QUEUE_STATISTICS
+	uint32_t frame_errors;	// frames dropped for a wrong crc or length
+	uint32_t errors[PL_LINK_ERROR_CODES];	// messages answered with e01..e06
+	uint32_t messages;	// messages handled
+	uint32_t parse_mean;	// time to handle a message, cycles (ns on the host)
+	uint32_t parse_max;
+} pl_link_statistics;
+
+void pl_link_statistics_get(pl_link_statistics *statistics);
+
 /*
  * Writes a log message to the visualization of the virtual peripheral.
  *
  */
 int pl_log(char* message);
 
+/*
+ * printf() (stdout and stderr) writes here on the board: the characters
+ * are buffered (PL_STDOUT_BUFFER_LEN in plib_config.h) and pl_do() sends
+ * each line as a log message, as far as the tx buffer has room; lines
+ * longer than 64 characters (58 with a tx buffer of 128 bytes) are split.
+ * It never waits: a write that does not fit into the buffer is dropped
+ * and counted (stdout_drops of pl_link_statistics). Returns the
+ * characters taken, 0 if dropped.
+ * Not for interrupt handlers. On the host port printf() writes to the
+ * terminal, call it directly for the log window.
+ */
+int pl_stdout_write(const char* data, int len);
+
 /*
  * Writes a debug message to the visualization of the virtual peripheral.
  * Note that this message will only be displayed if started with the command line option -d
@@ -101,26 +321,95 @@ int pl_screen_set(uint8_t screen);
 
 /*
  * Send data to display on alarm clock screen.
+ * Returns 1 if it changed, it is sent by pl_do() then.
  */
 int pl_alarmclock_display(uint32_t display);
 
 /*
  * Send data to display on the seesaw screen.
- *
+ * Can be called at any rate, pl_do() sends the latest data (see pl_flush_interval()).
  */
 int pl_seesaw_display(float reference, float position, float angle, int boing_state);
 
 /*
- * Returns the current time by setting the h/m/s parameters.
- * Prerequisite: pl_tick() is used. See function description.
+ * Wall time: kept by the RTC of the board (host port: the clock of the
+ * system), set from the PC by vPeripherals after pl_init(). Until then,
+ * and without vPeripherals, it starts at 2000-01-01 00:00:00 unless the
+ * RTC kept running over a reset. Costs no cpu time per tick.
+ */
+typedef struct pl_time {
+	uint16_t year;	// 2000..2099
+	uint8_t month;	// 1..12
+	uint8_t day;	// 1..31
+	uint8_t hour;	// 0..23
+	uint8_t min;
+	uint8_t sec;
+	uint16_t msec;	// 0..999
+} pl_time;
+
+void pl_time_get(pl_time *time);
+
+/*
+ * Returns the current time by setting the h/m/s parameters (see pl_time_get()).
  */
 void pl_get_hms(int *h, int *m, int *s);
 
 /*
- * Needs to be called every tick. When doing so, keeps the clock (see pl_get_hms() function) up-to-date.
- * You need to make sure that this function is called exactly every tick, otherwise the time will drift.
- *
+ * Needs to be called every tick, e.g. from SysTick_Handler(). Drives the
+ * timers, the rate limit of display updates and the link rates; the wall
+ * time (pl_time_get()) does not depend on it.
  */
 void pl_tick();
 
+/*
+ * Ticks counted by pl_tick() since start, wraps around after 2^32.
+ */
+uint32_t pl_ticks();
+
+/*
+ * Timers: pl_do() calls the handler of a timer once its time has come,
+ * in the super loop (not in an interrupt), and each handler runs to
+ * completion before the next one. The app owns the pl_timer, plib keeps
+ * the started ones ordered by due time, so pl_do() only looks at the
+ * earliest one. Times are in ticks of pl_tick().
+ *
+ * A periodic timer stays on its grid: if pl_do() comes later than a
+ * whole period, the handler runs once and the skipped runs are counted
+ * in misses (deadline misses). late_max is the latest run so far.
+ *
+ *   static pl_timer second;
+ *   static void on_second(pl_timer *timer) { ... }
+ *   pl_timer_start(&second, PL_TICKS_PER_SECOND, PL_TICKS_PER_SECOND, on_second);
+ */
+typedef struct pl_timer pl_timer;
+typedef void (*pl_timer_handler)(pl_timer *timer);
+
+struct pl_timer {
+	pl_timer_handler handler;
+	void *context;	// for the app, e.g. to share one handler
+	uint32_t due;	// pl_ticks() of the next run
+	uint32_t period;	// ticks between two runs, 0: once
+	uint32_t misses;	// runs skipped because pl_do() came a period or more too late
+	uint32_t late_max;	// ticks between due and run, the most so far
+	uint8_t slot;	// used by plib
+};
+
+/*
+ * Runs handler after delay ticks, then every period ticks (0: once).
+ * Starting a started timer schedules it anew. Returns -1 if PL_TIMERS
+ * timers are started already (plib_config.h), 1 otherwise.
+ * Call it from the super loop or a handler, not from an interrupt.
+ */
+int pl_timer_start(pl_timer *timer, uint32_t delay, uint32_t period, pl_timer_handler handler);
+
+/*
+ * Stops a timer, also from its own handler. Nothing happens if it is not started.
+ */
+void pl_timer_stop(pl_timer *timer);
+
+/*
+ * Returns 1 if the timer is started (a one shot timer stops when it runs).
+ */
+int pl_timer_started(const pl_timer *timer);
+
 #endif
@@ -8,9 +8,30 @@
 #define PL_TICKS_PER_SECOND 1000
 #define PL_BAUD 9600
 //#define PL_TX_BUSY_LED
+//#define PL_RX_CREDITS		// vPeripherals sends no more than fits into the rx buffer, see 'dC'
+#ifdef PL_RX_CREDITS
+#define PL_RX_BUFFER_LEN 256	// also the credit window of vPeripherals
+#else
 #define PL_RX_BUFFER_LEN 64
+#endif
 #define PL_TX_BUFFER_LEN 128
 #define PL_QUEUE_STATISTICS
+//#define PL_SERIAL_TX_DMA	// transmit with GPDMA instead of one interrupt per byte
+//#define PL_SERIAL_RX_DMA	// receive circularly with GPDMA, interrupts per half ring and idle line
+#define PL_RX_DMA_LEN 64	// ring for PL_SERIAL_RX_DMA
+#define PL_DO_BYTES 64		// bytes pl_do() parses per call at most
+#define PL_DO_CYCLES 0		// cycles pl_do() spends per call at most, 0: no limit
+#define PL_FLUSH_TICKS 40	// ticks between two sends of changed display values (25 per second)
+#define PL_TELEMETRY_CHANNELS 4	// see pl_telemetry_channel()
+#define PL_TELEMETRY_BUFFER_LEN 256	// samples waiting to be sent, a power of two
+#define PL_STDOUT_BUFFER_LEN 256	// printf() output waiting to be sent, a power of two
+//#define PL_PROFILING		// profiling zones, see plib_profile.h
+#define PL_PROFILE_TICKS 5000	// ticks between two reports of the profiling zones
+#define PL_ITEMS 24		// items of all screens, see pl_item_register()
+#define PL_TIMERS 8		// timers started at the same time, see pl_timer_start()
+//#define PL_BINARY_FRAMES	// offer SLIP frames with CRC-16 to vPeripherals, see plibi_frame.h
 #define PL_NUMBER_ADCS 2
+#define PL_ADC_NOISE_AMPLITUDE 896	// 3.5 adc steps, see pl_adc_noise()
+//#define PL_ADC_DMA		// pl_adc_get() reads the real adc (PA0, PA1), sampled continuously by GPDMA
 
 #endif 
@@ -0,0 +1,79 @@
+/*
+ * plib_profile.h
+ *
+ * Profiling zones: measure how long a piece of code takes, in CPU cycles
+ * (DWT cycle counter) on the board and in nanoseconds on the host port.
+ * Each zone collects count, min, max, mean and a histogram; pl_do() sends
+ * a report of all zones every PL_PROFILE_TICKS ticks to the debug window
+ * of vPeripherals (dD, shown with -d).
+ *
+ * Usage, e.g. for the body of the super loop:
+ *
+ *   while (1) {
+ *       PL_PROFILE_BEGIN(loop);
+ *       ...
+ *       PL_PROFILE_END(loop);
+ *   }
+ *
+ * BEGIN and END enclose a block, so they must be used in pairs in the
+ * same scope (like pthread_cleanup_push/pop), and the code between them
+ * must not leave with return, break or goto. The zone is named after the
+ * argument.
+ *
+ * Without PL_PROFILING in plib_config.h, the macros are empty and no
+ * profiling code is compiled.
+ */
+
+#ifndef PLIB_PROFILE_H_
+#define PLIB_PROFILE_H_
+
+#include <stdint.h>
+#include "plib_config.h"
+
+#define PL_PROFILE_BINS 8	// histogram: < 4, < 16, < 64, ... cycles, the last one all longer
+
+typedef struct pl_profile_zone {
+	const char *name;
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t histogram[PL_PROFILE_BINS];
+	struct pl_profile_zone *next;	// all zones, linked at their first use
+	uint8_t linked;
+} pl_profile_zone;
+
+#ifdef PL_PROFILING
+
+uint32_t pli_board_cycles(void);
+
+/*
+ * adds a duration to a zone, used by PL_PROFILE_END
+ */
+void pl_profile_add(pl_profile_zone *zone, uint32_t cycles);
+
+/*
+ * sends the statistics of all zones with pl_log_debug()
+ */
+void pl_profile_report(void);
+
+/*
+ * starts all zones again
+ */
+void pl_profile_reset(void);
+
+#define PL_PROFILE_BEGIN(zone) { \
+	static pl_profile_zone pl_profile_##zone = { #zone, 0, 0, 0, 0, { 0 }, 0, 0 }; \
+	uint32_t pl_profile_start_##zone = pli_board_cycles()
+
+#define PL_PROFILE_END(zone) \
+	pl_profile_add(&pl_profile_##zone, pli_board_cycles() - pl_profile_start_##zone); }
+
+#else
+
+#define PL_PROFILE_BEGIN(zone) {
+#define PL_PROFILE_END(zone) }
+
+#endif
+
+#endif
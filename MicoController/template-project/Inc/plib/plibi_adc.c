@@ -0,0 +1,122 @@
+/*
+ * Continuous adc sampling with GPDMA for the STM32H533 (see plibi_adc.h)
+ *
+ * The regular sequence of ADC1 holds the channels in order, in
+ * continuous mode the adc starts over after the last one. Its DMA
+ * requests are served by GPDMA1 channel 2, half words from the fixed DR
+ * to the incrementing samples. Like the rx ring of the serial link (see
+ * plibi_dma.c) a linked-list item pointing to itself reloads the
+ * channel after each sequence. No interrupts are used; an overrun only
+ * means the latest value is overwritten (OVRMOD).
+ */
+
+#ifndef PL_HOST
+
+#include "plibi_adc.h"
+#include "plibi_board.h"
+#include "plibi_mini_hal.h"
+#include "system_stm32h5xx.h"
+
+// GPDMA1 request line, see reference manual RM0481, GPDMA1 requests
+#define PL_DMA_REQUEST_ADC1 0
+
+#define ADC_SAMPLE_TIME 6	// 247.5 adc clocks, for sources up to some 10 kOhm
+
+static DMA_Channel_TypeDef *adc_channel = GPDMA1_Channel2;
+
+/*
+ * linked-list item: CBR1, CDAR, CLLR (see plibi_dma.c)
+ */
+static struct {
+	uint32_t cbr1;
+	uint32_t cdar;
+	uint32_t cllr;
+} __attribute__((aligned(4))) adc_item;
+
+static void wait_cycles(uint32_t cycles) {
+	uint32_t start = pli_board_cycles();
+
+	while (pli_board_cycles() - start < cycles)
+		;
+}
+
+static void adc_init(uint8_t channels) {
+	volatile uint32_t tmp;
+	uint32_t sequence = (uint32_t) (channels - 1) << ADC_SQR1_L_Pos;
+
+	SET_BIT(RCC->AHB2ENR, RCC_AHB2ENR_ADCEN | RCC_AHB2ENR_GPIOAEN);
+	/* Delay after an RCC peripheral clock enabling */
+	tmp = READ_BIT(RCC->AHB2ENR, RCC_AHB2ENR_ADCEN);
+	UNUSED(tmp);
+
+	// PA0 (channel 0) and PA1 (channel 1) are analog inputs
+	for (uint8_t i = 0; i < channels; i++)
+		MODIFY_REG(GPIOA->MODER, GPIO_MODER_MODE0_Msk << (2 * i),
+				GPIO_MODE_ANALOG << (2 * i));
+
+	// clock: hclk / 4, synchronous to the bus
+	MODIFY_REG(ADC12_COMMON->CCR, ADC_CCR_CKMODE, 3UL << ADC_CCR_CKMODE_Pos);
+
+	// leave deep power down, the regulator needs 20 us (t ADCVREG_STUP)
+	CLEAR_BIT(ADC1->CR, ADC_CR_DEEPPWD);
+	SET_BIT(ADC1->CR, ADC_CR_ADVREGEN);
+	wait_cycles(SystemCoreClock / 50000 + 1);
+
+	// single ended calibration
+	CLEAR_BIT(ADC1->CR, ADC_CR_ADCALDIF);
+	SET_BIT(ADC1->CR, ADC_CR_ADCAL);
+	while (READ_BIT(ADC1->CR, ADC_CR_ADCAL))
+		;
+
+	ADC1->ISR = ADC_ISR_ADRDY;
+	SET_BIT(ADC1->CR, ADC_CR_ADEN);
+	while (!READ_BIT(ADC1->ISR, ADC_ISR_ADRDY))
+		;
+
+	// channel i at rank i + 1, SQ1..SQ4 are in SQR1
+	for (uint8_t i = 0; i < channels; i++) {
+		sequence |= (uint32_t) i << (ADC_SQR1_SQ1_Pos + 6 * i);
+		ADC1->SMPR1 |= (uint32_t) ADC_SAMPLE_TIME << (ADC_SMPR1_SMP0_Pos + 3 * i);
+	}
+	ADC1->SQR1 = sequence;
+
+	// 10 bits, continuous, software start, circular DMA, overwrite on overrun
+	ADC1->CFGR = ADC_CFGR_RES_0 | ADC_CFGR_CONT | ADC_CFGR_DMAEN | ADC_CFGR_DMACFG
+			| ADC_CFGR_OVRMOD;
+}
+
+void pli_adc_start(volatile uint16_t *samples, uint8_t channels) {
+	uint32_t item = (uint32_t) (uintptr_t) &adc_item;
+	uint32_t link = (item & DMA_CLLR_LA) | DMA_CLLR_UB1 | DMA_CLLR_UDA
+			| DMA_CLLR_ULL;
+	volatile uint32_t tmp;
+
+	if (channels == 0 || channels > PLI_ADC_CHANNELS)
+		return;	// PA2 and PA3 are the link
+	adc_init(channels);
+
+	SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPDMA1EN);
+	/* Delay after an RCC peripheral clock enabling */
+	tmp = READ_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPDMA1EN);
+	UNUSED(tmp);
+
+	adc_item.cbr1 = (channels * sizeof(uint16_t)) & DMA_CBR1_BNDT;
+	adc_item.cdar = (uint32_t) (uintptr_t) samples;
+	adc_item.cllr = link;	// the item follows itself
+
+	adc_channel->CCR = 0;
+	// half words, source is the fixed DR, destination increments
+	adc_channel->CTR1 = DMA_CTR1_DINC | DMA_CTR1_SDW_LOG2_0 | DMA_CTR1_DDW_LOG2_0;
+	// request from the source (ADC1)
+	adc_channel->CTR2 = PL_DMA_REQUEST_ADC1 & DMA_CTR2_REQSEL;
+	adc_channel->CSAR = (uint32_t) (uintptr_t) &ADC1->DR;
+	adc_channel->CDAR = adc_item.cdar;
+	adc_channel->CBR1 = adc_item.cbr1;
+	adc_channel->CLBAR = item & DMA_CLBAR_LBA;
+	adc_channel->CLLR = link;
+	adc_channel->CCR = DMA_CCR_EN;
+
+	SET_BIT(ADC1->CR, ADC_CR_ADSTART);
+}
+
+#endif
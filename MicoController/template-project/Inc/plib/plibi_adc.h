@@ -0,0 +1,22 @@
+#ifndef PLIBI_ADC_H_
+#define PLIBI_ADC_H_
+
+#include <stdint.h>
+
+/*
+ * channels of the real adc: ADC1 channel 0 (PA0) and 1 (PA1). The next
+ * pins of port A, PA2 and PA3, are the link (USART2), and the further
+ * adc channels are on pins of other numbers.
+ */
+#define PLI_ADC_CHANNELS 2
+
+/*
+ * Real adc for pl_adc_get() (PL_ADC_DMA): ADC1 converts the channels
+ * 0..channels - 1 (at most PLI_ADC_CHANNELS) one after the other,
+ * endlessly, with a resolution of 10 bits like the virtual adcs. GPDMA1
+ * channel 2 writes each result to samples[channel], so the latest values
+ * are always in memory and a read costs nothing but the read.
+ */
+void pli_adc_start(volatile uint16_t *samples, uint8_t channels);
+
+#endif
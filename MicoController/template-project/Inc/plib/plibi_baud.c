@@ -0,0 +1,57 @@
+/*
+ * Baud rate register computation for the STM32 USART (see plibi_baud.h)
+ */
+
+#include <stdlib.h>
+
+#include "plibi_baud.h"
+
+// kernel clocks per bit the USART runs at with this BRR
+static uint32_t bit_clocks(uint32_t brr, uint8_t over8) {
+	// BRR[2:0] = USARTDIV[3:0] >> 1, bit 0 of USARTDIV does not reach the USART
+	return over8 ? ((brr & 0xfff0) | ((brr & 0x7) << 1)) / 2 : brr;
+}
+
+static int64_t error_ppm(uint32_t clock, uint32_t baud, uint32_t clocks) {
+	return ((int64_t) clock - (int64_t) clocks * baud) * 1000000 / ((int64_t) clocks * baud);
+}
+
+int pli_baud_compute(uint32_t clock, uint32_t baud, pli_baud* setting) {
+	uint64_t div16, div8;
+	uint32_t brr8 = 0, clocks;
+	int64_t error16 = 0, error8 = 0, error;
+
+	if (baud == 0)
+		return 0;
+	// USARTDIV rounded for both oversampling modes, 16 .. 0xffff each;
+	// BRR drops bit 0 with oversampling by 8, so that one is rounded to even
+	div16 = ((uint64_t) clock + baud / 2) / baud;
+	div8 = 2 * div16;
+	if (div16 >= 16 && div16 <= 0xffff)
+		error16 = error_ppm(clock, baud, (uint32_t) div16);
+	else
+		div16 = 0;
+	if (div8 >= 16 && div8 <= 0xffff) {
+		brr8 = (uint32_t) ((div8 & 0xfff0) | ((div8 & 0xf) >> 1));
+		error8 = error_ppm(clock, baud, bit_clocks(brr8, 1));
+	} else {
+		div8 = 0;
+	}
+	if (!div16 && !div8)
+		return 0;	// too fast or too slow for this clock
+
+	// the smaller error wins, oversampling by 16 tolerates more noise on a tie
+	if (div16 && (!div8 || llabs(error16) <= llabs(error8))) {
+		setting->over8 = 0;
+		setting->brr = (uint32_t) div16;
+		error = error16;
+	} else {
+		setting->over8 = 1;
+		setting->brr = brr8;
+		error = error8;
+	}
+	clocks = bit_clocks(setting->brr, setting->over8);
+	setting->actual = (clock + clocks / 2) / clocks;
+	setting->error_ppm = (int32_t) error;
+	return error <= PLI_BAUD_MAX_ERROR_PPM && error >= -PLI_BAUD_MAX_ERROR_PPM;
+}
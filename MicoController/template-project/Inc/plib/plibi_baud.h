@@ -0,0 +1,36 @@
+#ifndef PLIBI_BAUD_H_
+#define PLIBI_BAUD_H_
+
+#include <stdint.h>
+
+/*
+ * Baud rate register of the STM32 USART, computed from the kernel
+ * clock. Pure arithmetic, also used by the host build and the
+ * benchmark.
+ *
+ * USARTDIV is rounded for oversampling by 16 (clock / baud) and by 8
+ * (2 * clock / baud), both are rated by the rate the programmed BRR
+ * really gives and the smaller error wins. With oversampling by 8 BRR
+ * drops the lowest bit of USARTDIV, so a bit takes a whole number of
+ * kernel clocks in both modes and there is no half step to gain; by 8
+ * reaches up to clock / 8. Oversampling by 16 tolerates more noise and
+ * wins a tie.
+ */
+
+// largest deviation accepted, both ends of the link together must stay below ~3.5 %
+#define PLI_BAUD_MAX_ERROR_PPM 20000
+
+typedef struct pli_baud {
+    uint32_t brr;           // value for USART_BRR
+    uint8_t over8;          // value for USART_CR1.OVER8
+    uint32_t actual;        // resulting baud rate
+    int32_t error_ppm;      // (actual - baud) / baud in parts per million
+} pli_baud;
+
+/*
+ * returns 1 and fills setting if the rate can be reached within
+ * PLI_BAUD_MAX_ERROR_PPM, 0 otherwise
+ */
+int pli_baud_compute(uint32_t clock, uint32_t baud, pli_baud* setting);
+
+#endif
@@ -83,6 +83,29 @@ void pli_board_init(void) {
 	sysled_init();
 
 	userbutton_init();
+
+	// cycle counter, see pli_board_cycles()
+	DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t pli_board_cycles(void) {
+	return DWT->CYCCNT;
+}
+
+void pli_board_sleep_begin(void) {
+	__disable_irq();
+}
+
+void pli_board_sleep(void) {
+	// a pending interrupt ends WFI even while PRIMASK masks it
+	__DSB();
+	__WFI();
+}
+
+void pli_board_sleep_end(void) {
+	__enable_irq();	// the handler of the wakeup runs now
 }
 
 void pl_error(int component, int code) {
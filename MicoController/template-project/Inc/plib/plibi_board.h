@@ -3,9 +3,16 @@
 
 #include <stdint.h>
 #include "plib_config.h"
+
+/*
+ * PL_HOST builds plib for a Linux host (benchmarks, host port),
+ * there is no device header then.
+ */
+#ifndef PL_HOST
 #include "stm32h5xx.h"
 
 #define STM32H553xx
+#endif
 
 #if !defined(UNUSED)
 #define UNUSED(x) ((void)(x))
@@ -17,4 +24,35 @@ void pl_board_led_set(uint8_t val);
 
 int pl_board_button_get(void);
 
+void pl_error(int component, int code);
+
+/*
+ * free running cycle counter (DWT CYCCNT; nanoseconds on the host)
+ */
+uint32_t pli_board_cycles(void);
+
+/*
+ * sleep until an interrupt: between begin and end no interrupt handler
+ * runs (host: no simulated one), so the caller can check for work
+ * first and call pli_board_sleep() only if there is none, without
+ * missing an interrupt in between
+ */
+void pli_board_sleep_begin(void);
+
+void pli_board_sleep(void);
+
+void pli_board_sleep_end(void);
+
+#ifdef PL_HOST
+/*
+ * host: ends pli_board_sleep(), called by the simulated interrupts
+ */
+void pli_board_wake(void);
+
+/*
+ * generate n ticks (SysTick_Handler calls), for PLIB_TICK_US=0
+ */
+void pli_host_tick(unsigned int n);
+#endif
+
 #endif
@@ -0,0 +1,143 @@
+/*
+ * Board functions for running a plib application as a Linux process
+ * (PL_HOST). Replaces plibi_board.c.
+ *
+ * SysTick is simulated by a thread calling SysTick_Handler() every
+ * 1/PL_TICKS_PER_SECOND seconds. The period can be changed with the
+ * environment variable PLIB_TICK_US (microseconds). PLIB_TICK_US=0
+ * disables the thread, ticks are then only generated by pli_host_tick(),
+ * e.g. from a test driver or a benchmark.
+ */
+
+#ifdef PL_HOST
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "plibi_board.h"
+
+static uint8_t led_state;
+
+/*
+ * the virtual board has no user button, it is never pressed
+ */
+int pl_board_button_get(void) {
+	return 0;
+}
+
+void pl_board_led_set(uint8_t val) {
+	if (val != led_state) {
+		led_state = val;
+		fprintf(stderr, "plib: user led %s\n", val ? "on" : "off");
+	}
+}
+
+__attribute__((weak)) void SysTick_Handler(void) {
+	/*
+	 * dummy systick handler, see plibi_board.c
+	 */
+}
+
+/*
+ * sleeping between events: the simulated interrupts (ticks, DMA)
+ * call pli_board_wake(), the main thread waits on the condition.
+ * Whoever makes work for the main thread does so before taking
+ * sleep_lock, the sleeper checks for work while holding it.
+ */
+static pthread_mutex_t sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wakeup = PTHREAD_COND_INITIALIZER;
+
+void pli_board_sleep_begin(void) {
+	pthread_mutex_lock(&sleep_lock);
+}
+
+void pli_board_sleep(void) {
+	struct timespec until;
+
+	// at most 10 ms: the link is polled without DMA, see plibi_serial_host.c
+	clock_gettime(CLOCK_REALTIME, &until);	// the clock of pthread_cond_timedwait()
+	until.tv_nsec += 10000000L;
+	if (until.tv_nsec >= 1000000000L) {
+		until.tv_nsec -= 1000000000L;
+		until.tv_sec++;
+	}
+	pthread_cond_timedwait(&wakeup, &sleep_lock, &until);
+}
+
+void pli_board_sleep_end(void) {
+	pthread_mutex_unlock(&sleep_lock);
+}
+
+void pli_board_wake(void) {
+	pthread_mutex_lock(&sleep_lock);
+	pthread_cond_signal(&wakeup);
+	pthread_mutex_unlock(&sleep_lock);
+}
+
+void pli_host_tick(unsigned int n) {
+	while (n--)
+		SysTick_Handler();
+	pli_board_wake();
+}
+
+/*
+ * tick source, sleeps to absolute deadlines so the
+ * ticks do not drift with the time spent in the handler
+ */
+static void* tick_thread(void *arg) {
+	long period_ns = *(long*) arg;
+	struct timespec next;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (1) {
+		next.tv_nsec += period_ns;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL)
+				== EINTR)
+			;
+		SysTick_Handler();
+		pli_board_wake();
+	}
+	return NULL;
+}
+
+void pli_board_init(void) {
+	static long period_ns = 1000000000L / PL_TICKS_PER_SECOND;
+	static int started = 0;
+	const char *env = getenv("PLIB_TICK_US");
+	pthread_t thread;
+
+	if (started)
+		return;
+	started = 1;
+
+	if (env)
+		period_ns = strtol(env, NULL, 10) * 1000L;
+	if (period_ns <= 0)
+		return;	// manual ticks with pli_host_tick()
+
+	if (pthread_create(&thread, NULL, tick_thread, &period_ns) != 0) {
+		pl_error(1, 1);
+	}
+	pthread_detach(thread);
+}
+
+uint32_t pli_board_cycles(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t) (now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+void pl_error(int component, int code) {
+	fprintf(stderr, "plib: error %d in component %d\n", code, component);
+	exit(1);
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Hex and decimal fields of the plib protocol (see plibi_codec.h)
+ */
+
+#include <string.h>
+#include "plibi_codec.h"
+
+// '0'..'9' and 'a'..'f', the upper case letters are no digits of the protocol
+const int8_t pli_hex_values[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+// the two digits of every byte, "00" "01" .. "ff"
+static const char hex_pairs[512] =
+	"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+	"202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+	"404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+	"606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+	"808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+	"a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+	"c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+	"e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+void pli_hex_encode8(uint8_t value, char *d) {
+	memcpy(d, hex_pairs + 2 * value, 2);
+}
+
+void pli_hex_encode16(uint16_t value, char *d) {
+	memcpy(d, hex_pairs + 2 * (value >> 8), 2);
+	memcpy(d + 2, hex_pairs + 2 * (value & 0xff), 2);
+}
+
+void pli_hex_encode32(uint32_t value, char *d) {
+	memcpy(d, hex_pairs + 2 * (value >> 24), 2);
+	memcpy(d + 2, hex_pairs + 2 * (value >> 16 & 0xff), 2);
+	memcpy(d + 4, hex_pairs + 2 * (value >> 8 & 0xff), 2);
+	memcpy(d + 6, hex_pairs + 2 * (value & 0xff), 2);
+}
+
+int pli_hex_decode(const char *text, int digits, uint32_t *out) {
+	uint32_t value = 0;
+	int8_t bad = 0;
+
+	for (int i = 0; i < digits; i++) {
+		int8_t v = pli_hex_values[(uint8_t) text[i]];
+
+		bad |= v;	// -1 sets the sign
+		value = value << 4 | (v & 0x0f);
+	}
+	if (bad < 0)
+		return 0;
+	*out = value;
+	return 1;
+}
+
+int pli_dec_decode(const char *text, int digits, uint32_t *out) {
+	uint32_t value = 0;
+	int8_t bad = 0;
+
+	for (int i = 0; i < digits; i++) {
+		int8_t v = pli_hex_values[(uint8_t) text[i]];
+
+		bad |= v | (9 - v);	// negative for -1 and for 'a'..'f'
+		value = value * 10 + v;
+	}
+	if (bad < 0)
+		return 0;
+	*out = value;
+	return 1;
+}
@@ -0,0 +1,48 @@
+#ifndef PLIBI_CODEC_H_
+#define PLIBI_CODEC_H_
+
+#include <stdint.h>
+
+/*
+ * Hex and decimal fields of the plib protocol (lower case hex, most
+ * significant digit first). Pure arithmetic, also used by the framing
+ * and the benchmark.
+ *
+ * Both directions are table driven, without a branch per digit:
+ * encoding copies the two digits of each byte from a table of all 256
+ * pairs, decoding looks every character up in a table of 256 values,
+ * -1 for no digit. The -1s are or-ed over the whole field and checked
+ * once at its end.
+ */
+
+extern const int8_t pli_hex_values[256];
+
+/*
+ * value of a hex digit, -1 if c is none
+ */
+static inline int pli_hex_value(char c) {
+	return pli_hex_values[(uint8_t) c];
+}
+
+/*
+ * write 2, 4 or 8 hex digits to d, without a terminating 0
+ */
+void pli_hex_encode8(uint8_t value, char *d);
+
+void pli_hex_encode16(uint16_t value, char *d);
+
+void pli_hex_encode32(uint32_t value, char *d);
+
+/*
+ * value of digits (1..8) hex digits in text, returns 1 and sets out if
+ * all of them are hex digits, 0 otherwise. All digits are read, text
+ * must hold at least as many characters.
+ */
+int pli_hex_decode(const char *text, int digits, uint32_t *out);
+
+/*
+ * value of digits (1..9) decimal digits in text, like pli_hex_decode()
+ */
+int pli_dec_decode(const char *text, int digits, uint32_t *out);
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Calendar arithmetic (see plibi_date.h)
+ */
+
+#include "plibi_date.h"
+
+#define SECONDS_PER_DAY 86400UL
+#define DAYS_PER_ERA 146097UL	// 400 years
+#define DAYS_TO_2000 730425UL	// from 0000-03-01
+
+int pli_days_of_month(int year, int month) {
+	if (month == 2) {
+		if (((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0)) {
+			return 29;
+		} else {
+			return 28;
+		}
+	}
+
+	if ((month == 4) || (month == 6) || (month == 9) || (month == 11)) {
+		return 30;
+	}
+	return 31;
+}
+
+int pli_date_valid(const pl_time *time) {
+	return time->year >= 2000 && time->year <= 2099
+			&& time->month >= 1 && time->month <= 12
+			&& time->day >= 1 && time->day <= pli_days_of_month(time->year, time->month)
+			&& time->hour <= 23 && time->min <= 59 && time->sec <= 59;
+}
+
+/*
+ * days since 2000-01-01, counted in years starting at march 1st,
+ * so the leap day is the last day of a year (H. Hinnant, days_from_civil)
+ */
+static uint32_t days_since_2000(unsigned year, unsigned month, unsigned day) {
+	unsigned era, year_of_era, day_of_year;
+
+	if (month <= 2)
+		year--;
+	era = year / 400;
+	year_of_era = year - era * 400;
+	day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	return era * DAYS_PER_ERA + year_of_era * 365 + year_of_era / 4 - year_of_era / 100
+			+ day_of_year - DAYS_TO_2000;
+}
+
+uint32_t pli_date_to_seconds(const pl_time *time) {
+	return days_since_2000(time->year, time->month, time->day) * SECONDS_PER_DAY
+			+ time->hour * 3600UL + time->min * 60UL + time->sec;
+}
+
+void pli_date_from_seconds(uint32_t seconds, pl_time *time) {
+	uint32_t days = seconds / SECONDS_PER_DAY + DAYS_TO_2000;
+	uint32_t rest = seconds % SECONDS_PER_DAY;
+	unsigned era, day_of_era, year_of_era, day_of_year, month_from_march;
+
+	era = days / DAYS_PER_ERA;
+	day_of_era = days - era * DAYS_PER_ERA;
+	year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524
+			- day_of_era / (DAYS_PER_ERA - 1)) / 365;
+	day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+	month_from_march = (5 * day_of_year + 2) / 153;
+
+	time->day = day_of_year - (153 * month_from_march + 2) / 5 + 1;
+	time->month = month_from_march < 10 ? month_from_march + 3 : month_from_march - 9;
+	time->year = era * 400 + year_of_era + (time->month <= 2);
+	time->hour = rest / 3600;
+	time->min = rest / 60 % 60;
+	time->sec = rest % 60;
+	time->msec = 0;
+}
+
+int pli_date_weekday(const pl_time *time) {
+	// 2000-01-01 was a saturday
+	return (days_since_2000(time->year, time->month, time->day) + 5) % 7 + 1;
+}
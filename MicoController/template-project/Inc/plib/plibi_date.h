@@ -0,0 +1,42 @@
+#ifndef PLIBI_DATE_H_
+#define PLIBI_DATE_H_
+
+#include <stdint.h>
+#include "plib.h"
+
+/*
+ * Calendar arithmetic for the wall clock (pl_time_get()). Pure
+ * arithmetic, also used by the host port and the benchmark.
+ *
+ * Times count in seconds since 2000-01-01 00:00:00, which covers the
+ * years of the RTC (2000..2099) in 32 bits. Leap years follow the
+ * Gregorian rules, so 2000 is one.
+ */
+
+/*
+ * days of month (1..12) in year
+ */
+int pli_days_of_month(int year, int month);
+
+/*
+ * returns 1 if time is a date and time of 2000..2099, 0 otherwise
+ * (msec is not checked)
+ */
+int pli_date_valid(const pl_time *time);
+
+/*
+ * seconds since 2000-01-01 00:00:00 of a valid time
+ */
+uint32_t pli_date_to_seconds(const pl_time *time);
+
+/*
+ * the time seconds after 2000-01-01 00:00:00, msec is set to 0
+ */
+void pli_date_from_seconds(uint32_t seconds, pl_time *time);
+
+/*
+ * day of the week of a valid time, 1 (monday) .. 7 (sunday) like RTC_DR.WDU
+ */
+int pli_date_weekday(const pl_time *time);
+
+#endif
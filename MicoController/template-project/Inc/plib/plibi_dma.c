@@ -0,0 +1,123 @@
+/*
+ * DMA backend for the STM32H533: GPDMA1 channel 0 feeds the
+ * transmit data register of USART2, channel 1 receives from it
+ * (see plibi_dma.h)
+ *
+ * Each tx span is a single block transfer, memory (incrementing) to
+ * peripheral (fixed), bytes, triggered by the USART2 tx request.
+ *
+ * GPDMA has no circular mode, reception loops with a linked list of
+ * one item that points to itself and reloads block size and
+ * destination address after each pass through the ring.
+ */
+
+#ifndef PL_HOST
+
+#include "plibi_dma.h"
+#include "plibi_board.h"
+
+// GPDMA1 request lines, see reference manual RM0481, GPDMA1 requests
+#define PL_DMA_REQUEST_USART2_RX 23
+#define PL_DMA_REQUEST_USART2_TX 24
+
+static DMA_Channel_TypeDef *tx_channel = GPDMA1_Channel0;
+static DMA_Channel_TypeDef *rx_channel = GPDMA1_Channel1;
+
+/*
+ * linked-list item, contains the registers selected by the update
+ * bits in CLLR, in register order: CBR1, CDAR, CLLR
+ */
+static struct {
+	uint32_t cbr1;
+	uint32_t cdar;
+	uint32_t cllr;
+} __attribute__((aligned(4))) rx_item;
+
+static uint_fast16_t rx_size;
+
+void pli_dma_init(void) {
+	volatile uint32_t tmp;
+	uint32_t prio;
+
+	SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPDMA1EN);
+	/* Delay after an RCC peripheral clock enabling */
+	tmp = READ_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPDMA1EN);
+	UNUSED(tmp);
+
+	// byte wide, source increments, destination is the fixed TDR
+	tx_channel->CTR1 = DMA_CTR1_SINC;
+	// request from the destination (USART2 tx)
+	tx_channel->CTR2 = DMA_CTR2_DREQ
+			| (PL_DMA_REQUEST_USART2_TX & DMA_CTR2_REQSEL);
+	tx_channel->CDAR = (uint32_t) (uintptr_t) &USART2->TDR;
+	tx_channel->CLLR = 0;	// no linked list, one block per span
+
+	prio = NVIC_GetPriorityGrouping();
+	NVIC_SetPriority(GPDMA1_Channel0_IRQn, NVIC_EncodePriority(prio, 0, 0));
+	NVIC_EnableIRQ(GPDMA1_Channel0_IRQn);
+	NVIC_SetPriority(GPDMA1_Channel1_IRQn, NVIC_EncodePriority(prio, 0, 0));
+	NVIC_EnableIRQ(GPDMA1_Channel1_IRQn);
+}
+
+void pli_dma_tx_start(const uint8_t* data, uint_fast16_t len) {
+	tx_channel->CFCR = DMA_CFCR_TCF;
+	tx_channel->CSAR = (uint32_t) (uintptr_t) data;
+	tx_channel->CBR1 = len & DMA_CBR1_BNDT;
+	tx_channel->CCR = DMA_CCR_TCIE | DMA_CCR_DTEIE | DMA_CCR_USEIE
+			| DMA_CCR_EN;
+}
+
+void GPDMA1_Channel0_IRQHandler(void) {
+	uint32_t status = tx_channel->CSR;
+
+	if (status & (DMA_CSR_DTEF | DMA_CSR_USEF)) {
+		// transfer or setting error: the channel is disabled by hardware
+		pl_error(2, 1);
+	}
+	if (status & DMA_CSR_TCF) {
+		tx_channel->CFCR = DMA_CFCR_TCF;
+		pli_dma_tx_complete();
+	}
+}
+
+void pli_dma_rx_start(uint8_t* ring, uint_fast16_t size) {
+	uint32_t item = (uint32_t) (uintptr_t) &rx_item;
+	uint32_t link = (item & DMA_CLLR_LA) | DMA_CLLR_UB1 | DMA_CLLR_UDA
+			| DMA_CLLR_ULL;
+
+	rx_size = size;
+	rx_item.cbr1 = size & DMA_CBR1_BNDT;
+	rx_item.cdar = (uint32_t) (uintptr_t) ring;
+	rx_item.cllr = link;	// the item follows itself
+
+	rx_channel->CCR = 0;
+	rx_channel->CFCR = DMA_CFCR_TCF | DMA_CFCR_HTF;
+	// byte wide, source is the fixed RDR, destination increments
+	rx_channel->CTR1 = DMA_CTR1_DINC;
+	// request from the source (USART2 rx)
+	rx_channel->CTR2 = PL_DMA_REQUEST_USART2_RX & DMA_CTR2_REQSEL;
+	rx_channel->CSAR = (uint32_t) (uintptr_t) &USART2->RDR;
+	rx_channel->CDAR = rx_item.cdar;
+	rx_channel->CBR1 = rx_item.cbr1;
+	rx_channel->CLBAR = item & DMA_CLBAR_LBA;
+	rx_channel->CLLR = link;
+	rx_channel->CCR = DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_DTEIE
+			| DMA_CCR_USEIE | DMA_CCR_EN;
+}
+
+uint_fast16_t pli_dma_rx_position(void) {
+	// BNDT counts the bytes left in this pass, the write position is the rest
+	return rx_size - (rx_channel->CBR1 & DMA_CBR1_BNDT);
+}
+
+void GPDMA1_Channel1_IRQHandler(void) {
+	uint32_t status = rx_channel->CSR;
+
+	if (status & (DMA_CSR_DTEF | DMA_CSR_USEF)) {
+		pl_error(2, 2);
+	}
+	rx_channel->CFCR = status & (DMA_CSR_TCF | DMA_CSR_HTF);
+	pli_dma_rx_poll();
+}
+
+#endif
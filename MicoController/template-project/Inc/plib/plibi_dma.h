@@ -0,0 +1,67 @@
+#ifndef PLIBI_DMA_H_
+#define PLIBI_DMA_H_
+
+#include <stdint.h>
+#include "plibi_queue.h"
+
+/*
+ * DMA transmission of a queue (PL_SERIAL_TX_DMA) and circular DMA
+ * reception into a queue (PL_SERIAL_RX_DMA).
+ *
+ * The chaining logic (plibi_dma_tx.c) hands the contiguous spans of the
+ * tx queue to a DMA channel, one at a time, and starts the next span when
+ * the channel reports completion. It does not know the hardware, the
+ * channel is driven by a backend:
+ * - plibi_dma.c: GPDMA1 of the STM32H533, feeding USART2
+ * - plibi_dma_host.c: simulated controller for the Linux host port
+ * - the benchmark brings its own simulation to check the chaining
+ *
+ * For reception the channel writes endlessly into a ring buffer. On
+ * half transfer, transfer complete and an idle line the backend calls
+ * pli_dma_rx_poll(), which copies everything new from the ring into
+ * the rx queue at once.
+ */
+
+/*
+ * backend: set up the channel
+ */
+void pli_dma_init(void);
+
+/*
+ * backend: start transferring len bytes from data, len > 0.
+ * Never called while a transfer is running. When done, the backend
+ * calls pli_dma_tx_complete(), usually from its interrupt.
+ */
+void pli_dma_tx_start(const uint8_t* data, uint_fast16_t len);
+
+/*
+ * backend: receive circularly into ring (size bytes)
+ */
+void pli_dma_rx_start(uint8_t* ring, uint_fast16_t size);
+
+/*
+ * backend: position in ring the channel writes next
+ */
+uint_fast16_t pli_dma_rx_position(void);
+
+/*
+ * chaining logic
+ */
+void pli_dma_tx_init(pli_queue* q);
+
+void pli_dma_tx_kick(void);        // producer: data was enqueued, start if idle
+
+void pli_dma_tx_complete(void);    // backend: the running transfer is done
+
+int pli_dma_tx_busy(void);
+
+/*
+ * reception
+ */
+void pli_dma_rx_init(pli_queue* q, uint8_t* ring, uint_fast16_t size);
+
+void pli_dma_rx_poll(void);        // backend: from the interrupts, moves new bytes to the queue
+
+uint32_t pli_dma_rx_drops(void);   // bytes lost because the queue was full
+
+#endif
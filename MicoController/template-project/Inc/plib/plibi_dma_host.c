@@ -0,0 +1,127 @@
+/*
+ * Simulated DMA controller for the Linux host port (PL_HOST),
+ * replaces plibi_dma.c
+ *
+ * A thread plays the DMA channel: it takes the span handed over by
+ * pli_dma_tx_start(), writes it to the link to vPeripherals and calls
+ * pli_dma_tx_complete() like the transfer complete interrupt would.
+ * With the environment variable PLIB_BAUD set, each transfer takes as
+ * long as on a UART with that baud rate (10 bits per byte).
+ *
+ * A second thread plays the receive channel: it reads the link into
+ * the ring and calls pli_dma_rx_poll() on half transfer, transfer
+ * complete and when the link has nothing more (idle line).
+ */
+
+#ifdef PL_HOST
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "plibi_dma.h"
+#include "plibi_board.h"
+#include "plibi_serial.h"
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t requested = PTHREAD_COND_INITIALIZER;
+static const uint8_t* source;
+static uint_fast16_t count;	// bytes of the requested transfer, 0 if idle
+static long ns_per_byte;
+
+static uint8_t* rx_ring;
+static uint_fast16_t rx_size;
+static uint_fast16_t rx_pos;	// next byte written in rx_ring
+
+static void* channel_thread(void *arg) {
+	const uint8_t* data;
+	uint_fast16_t len;
+
+	while (1) {
+		pthread_mutex_lock(&lock);
+		while (count == 0)
+			pthread_cond_wait(&requested, &lock);
+		data = source;
+		len = count;
+		count = 0;
+		pthread_mutex_unlock(&lock);
+
+		pli_host_link_write(data, len);
+		if (ns_per_byte) {
+			long ns = ns_per_byte * len;
+			struct timespec t = { ns / 1000000000L, ns % 1000000000L };
+			nanosleep(&t, NULL);
+		}
+		pli_dma_tx_complete();	// "interrupt", may start the next transfer
+	}
+	return NULL;
+}
+
+static void* rx_channel_thread(void *arg) {
+	const struct timespec idle_wait = { 0, 1000000 };
+	uint_fast16_t pos, half = rx_size / 2;
+	size_t n;
+	int pending = 0;	// received since the last poll
+
+	while (1) {
+		pos = __atomic_load_n(&rx_pos, __ATOMIC_RELAXED);
+		// like the channel, stop at half and end of the ring
+		n = pli_host_link_read(rx_ring + pos, (pos < half ? half : rx_size) - pos);
+		if (n == 0) {
+			if (pending) {
+				pli_dma_rx_poll();	// idle line
+				pli_board_wake();
+			}
+			pending = 0;
+			nanosleep(&idle_wait, NULL);
+			continue;
+		}
+		pos += n;
+		__atomic_store_n(&rx_pos, pos, __ATOMIC_RELEASE);
+		pending = 1;
+		if (pos == half || pos == rx_size) {
+			pli_dma_rx_poll();	// half transfer, transfer complete
+			pli_board_wake();
+			pending = 0;
+		}
+		if (pos == rx_size)
+			__atomic_store_n(&rx_pos, 0, __ATOMIC_RELEASE);	// reload
+	}
+	return NULL;
+}
+
+void pli_dma_init(void) {
+	const char *baud = getenv("PLIB_BAUD");
+	pthread_t thread;
+
+	if (baud && atol(baud) > 0)
+		ns_per_byte = 10 * 1000000000L / atol(baud);
+	if (pthread_create(&thread, NULL, channel_thread, NULL) != 0)
+		pl_error(2, 1);
+	pthread_detach(thread);
+}
+
+void pli_dma_tx_start(const uint8_t* data, uint_fast16_t len) {
+	pthread_mutex_lock(&lock);
+	source = data;
+	count = len;
+	pthread_cond_signal(&requested);
+	pthread_mutex_unlock(&lock);
+}
+
+void pli_dma_rx_start(uint8_t* ring, uint_fast16_t size) {
+	pthread_t thread;
+
+	rx_ring = ring;
+	rx_size = size;
+	rx_pos = 0;
+	if (pthread_create(&thread, NULL, rx_channel_thread, NULL) != 0)
+		pl_error(2, 2);
+	pthread_detach(thread);
+}
+
+uint_fast16_t pli_dma_rx_position(void) {
+	return __atomic_load_n(&rx_pos, __ATOMIC_ACQUIRE);
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Circular DMA reception into the rx queue, independent of the
+ * DMA hardware (see plibi_dma.h)
+ *
+ * The channel writes into the ring without ever stopping; read marks
+ * how far the ring has been copied to the queue. Everything between
+ * read and the channel position is new and moved at once, in at most
+ * two spans. What does not fit into the queue is counted and dropped.
+ * pli_dma_rx_poll() is only called from interrupts of equal priority,
+ * so it never runs twice at the same time.
+ */
+
+#include "plibi_dma.h"
+
+static pli_queue* queue;
+static uint8_t* ring;
+static uint_fast16_t ring_size;
+static uint_fast16_t read;
+static uint32_t drops;
+
+static void deliver(const uint8_t* data, uint_fast16_t len) {
+	uint_fast16_t n = pli_enqueue_bulk(queue, data, len);
+
+	if (n < len)
+		__atomic_store_n(&drops, drops + (len - n), __ATOMIC_RELAXED);
+}
+
+void pli_dma_rx_init(pli_queue* q, uint8_t* ring_p, uint_fast16_t size) {
+	queue = q;
+	ring = ring_p;
+	ring_size = size;
+	read = 0;
+	drops = 0;
+	pli_dma_rx_start(ring, size);
+}
+
+void pli_dma_rx_poll(void) {
+	uint_fast16_t pos = pli_dma_rx_position();
+
+	if (pos == ring_size)
+		pos = 0;	// the channel is about to reload
+	if (pos == read)
+		return;
+	if (pos > read) {
+		deliver(ring + read, pos - read);
+	} else {
+		// the channel wrapped around
+		deliver(ring + read, ring_size - read);
+		deliver(ring, pos);
+	}
+	read = pos;
+}
+
+uint32_t pli_dma_rx_drops(void) {
+	return __atomic_load_n(&drops, __ATOMIC_RELAXED);
+}
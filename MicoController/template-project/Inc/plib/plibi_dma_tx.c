@@ -0,0 +1,67 @@
+/*
+ * Chaining of DMA transfers for the tx queue, independent of the
+ * DMA hardware (see plibi_dma.h)
+ *
+ * Whoever sets busy from 0 to 1 owns the consumer side of the queue
+ * until it clears busy again: the producer via pli_dma_tx_kick() when
+ * the channel is idle, the completion interrupt while transfers are
+ * chained. So there is always only one consumer, and at most one
+ * transfer is running.
+ */
+
+#include "plibi_dma.h"
+
+static pli_queue* queue;
+static uint_fast16_t in_flight;    // bytes of the running transfer
+static int busy;
+
+/*
+ * start the next span, or give up ownership when the queue is empty
+ */
+static void start_next(void) {
+	const uint8_t* data;
+	uint_fast16_t len;
+
+	while (1) {
+		len = pli_queue_span(queue, &data);
+		if (len) {
+			in_flight = len;
+			pli_dma_tx_start(data, len);
+			return;
+		}
+		__atomic_store_n(&busy, 0, __ATOMIC_SEQ_CST);
+		// the producer may have enqueued and seen busy==1 just before
+		if (pli_queue_empty(queue))
+			return;
+		int idle = 0;
+		if (!__atomic_compare_exchange_n(&busy, &idle, 1, 0, __ATOMIC_SEQ_CST,
+				__ATOMIC_SEQ_CST))
+			return;	// the producer took over
+	}
+}
+
+void pli_dma_tx_init(pli_queue* q) {
+	queue = q;
+	in_flight = 0;
+	busy = 0;
+}
+
+void pli_dma_tx_kick(void) {
+	int idle = 0;
+
+	if (__atomic_load_n(&busy, __ATOMIC_SEQ_CST))
+		return;	// running, the completion picks up the new data
+	if (__atomic_compare_exchange_n(&busy, &idle, 1, 0, __ATOMIC_SEQ_CST,
+			__ATOMIC_SEQ_CST))
+		start_next();
+}
+
+void pli_dma_tx_complete(void) {
+	pli_queue_release(queue, in_flight);
+	in_flight = 0;
+	start_next();
+}
+
+int pli_dma_tx_busy(void) {
+	return __atomic_load_n(&busy, __ATOMIC_SEQ_CST);
+}
@@ -0,0 +1,253 @@
+/*
+ * Binary framing of the plib messages (see plibi_frame.h)
+ */
+
+#include <string.h>
+
+#include "plibi_frame.h"
+#include "plibi_serial.h"
+#include "plibi_codec.h"
+
+/*
+ * messages sent packed, type 0x81 + index; both sides share this
+ * table (vPeripherals: frames.py)
+ */
+static const struct {
+	char prefix[4];
+	uint8_t bytes;	// hex digits / 2 following the prefix, 0: all of them
+} packed[] = {
+	{ "d1", 4 },	// alarm clock display
+	{ "d2", 6 },	// seesaw, followed by 't' or 'f'
+	{ "d00", 1 },	// led
+	{ "d01", 1 },	// switch
+	{ "d02", 1 },	// button
+	{ "d0a", 2 },	// adc
+	{ "d0b", 2 },
+	{ "d0c", 2 },
+	{ "dY", 0 },	// telemetry block: all digits, see plibi_main.c
+};
+
+#define PACKED (sizeof(packed) / sizeof(packed[0]))
+
+uint16_t pli_crc16(uint16_t crc, uint8_t data) {
+	crc ^= (uint16_t) data << 8;
+	for (int i = 0; i < 8; i++)
+		crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+	return crc;
+}
+
+/*
+ * sender
+ */
+static void put_escaped(pli_frame_tx *tx, uint8_t b) {
+	tx->crc = pli_crc16(tx->crc, b);
+	if (b == PLI_FRAME_END) {
+		pli_serial_write(PLI_FRAME_ESC);
+		pli_serial_write(PLI_FRAME_ESC_END);
+	} else if (b == PLI_FRAME_ESC) {
+		pli_serial_write(PLI_FRAME_ESC);
+		pli_serial_write(PLI_FRAME_ESC_ESC);
+	} else {
+		pli_serial_write(b);
+	}
+}
+
+static void begin(pli_frame_tx *tx, uint8_t type) {
+	tx->crc = 0xffff;
+	put_escaped(tx, type);
+}
+
+static void end(pli_frame_tx *tx) {
+	uint16_t crc = tx->crc;
+
+	put_escaped(tx, crc >> 8);
+	put_escaped(tx, crc & 0xff);
+	pli_serial_write(PLI_FRAME_END);
+}
+
+/*
+ * type of the message in head, PLI_FRAME_TEXT if it cannot be packed
+ */
+static uint8_t type_of(const char *text, int len, int *prefix) {
+	for (unsigned i = 0; i < PACKED; i++) {
+		int n = strlen(packed[i].prefix);
+		int j;
+
+		int digits = packed[i].bytes ? 2 * packed[i].bytes : len - n;
+
+		if (len < n + digits || memcmp(text, packed[i].prefix, n) != 0)
+			continue;
+		if (!packed[i].bytes && (digits == 0 || (len < PLI_FRAME_HEAD && digits % 2)))
+			continue;	// nothing to pack or an odd digit left over
+		for (j = n; j < n + digits; j++)
+			if (pli_hex_value(text[j]) < 0)
+				break;
+		if (j < n + digits)
+			continue;	// not hex, send as text
+		*prefix = n;
+		return PLI_FRAME_TEXT + 1 + i;
+	}
+	*prefix = 0;
+	return PLI_FRAME_TEXT;
+}
+
+static void send_head(pli_frame_tx *tx) {
+	int prefix, i;
+	uint8_t type = type_of(tx->head, tx->len, &prefix);
+
+	begin(tx, type);
+	i = prefix;
+	if (type != PLI_FRAME_TEXT) {
+		int bytes = packed[type - PLI_FRAME_TEXT - 1].bytes;
+
+		if (!bytes) {
+			// all digits, the ones still to come too
+			bytes = (tx->len - prefix) / 2;
+			tx->packing = 1;
+		}
+		for (int k = 0; k < bytes; k++, i += 2)
+			put_escaped(tx, pli_hex_value(tx->head[i]) << 4 | pli_hex_value(tx->head[i + 1]));
+		if (tx->packing && i < tx->len)
+			tx->nibble = pli_hex_value(tx->head[i++]) | 0x10;
+	}
+	for (; i < tx->len; i++)
+		put_escaped(tx, tx->head[i]);
+}
+
+void pli_frame_tx_init(pli_frame_tx *tx) {
+	tx->len = 0;
+	tx->streaming = 0;
+	tx->packing = 0;
+	tx->nibble = 0;
+}
+
+void pli_frame_tx_put(pli_frame_tx *tx, char c) {
+	if (c == '\n') {
+		if (!tx->streaming)
+			send_head(tx);
+		end(tx);
+		tx->len = 0;
+		tx->streaming = 0;
+		tx->packing = 0;
+		tx->nibble = 0;	// an odd digit is lost
+	} else if (tx->packing) {
+		int v = pli_hex_value(c);
+
+		if (v < 0)
+			return;	// only digits can follow
+		if (tx->nibble) {
+			put_escaped(tx, (tx->nibble & 0x0f) << 4 | v);
+			tx->nibble = 0;
+		} else {
+			tx->nibble = v | 0x10;
+		}
+	} else if (tx->streaming) {
+		put_escaped(tx, c);
+	} else if (tx->len < PLI_FRAME_HEAD) {
+		tx->head[tx->len++] = c;
+	} else {
+		// too long to be buffered: send while it is written
+		send_head(tx);
+		tx->streaming = 1;
+		pli_frame_tx_put(tx, c);
+	}
+}
+
+/*
+ * receiver
+ */
+static int unpack(const uint8_t *data, int len, char *text, int size) {
+	uint8_t type = data[0];
+	int n = 0;
+
+	data++;
+	len--;
+	if (type != PLI_FRAME_TEXT) {
+		unsigned i = type - PLI_FRAME_TEXT - 1;
+		int prefix;
+
+		int bytes;
+
+		if (i >= PACKED || len < packed[i].bytes)
+			return -1;
+		bytes = packed[i].bytes ? packed[i].bytes : len;
+		prefix = strlen(packed[i].prefix);
+		if (prefix + 2 * bytes >= size)
+			return -1;
+		memcpy(text, packed[i].prefix, prefix);
+		n = prefix;
+		for (int k = 0; k < bytes; k++, n += 2)
+			pli_hex_encode8(data[k], text + n);
+		data += bytes;
+		len -= bytes;
+	}
+	if (n + len >= size)
+		return -1;
+	memcpy(text + n, data, len);
+	n += len;
+	text[n] = 0;
+	return n;
+}
+
+void pli_frame_rx_init(pli_frame_rx *rx) {
+	rx->len = 0;
+	rx->frame = 0;
+	rx->escape = 0;
+	rx->overflow = 0;
+	rx->errors = 0;
+}
+
+static void rx_restart(pli_frame_rx *rx) {
+	rx->len = 0;
+	rx->frame = 0;
+	rx->escape = 0;
+	rx->overflow = 0;
+}
+
+int pli_frame_rx_put(pli_frame_rx *rx, uint8_t b, char *text, int size) {
+	int n = 0;
+
+	if (rx->len == 0 && !rx->frame && !rx->overflow
+			&& b >= PLI_FRAME_TEXT && b <= PLI_FRAME_TYPE_LAST)
+		rx->frame = 1;
+
+	if (rx->frame) {
+		if (b == PLI_FRAME_END) {
+			uint16_t crc = 0xffff;
+
+			for (int i = 0; i < rx->len; i++)
+				crc = pli_crc16(crc, rx->buffer[i]);
+			// the crc over payload and crc is 0
+			if (rx->overflow || rx->len < 3 || crc != 0
+					|| (n = unpack(rx->buffer, rx->len - 2, text, size)) < 0) {
+				rx->errors++;
+				n = 0;
+			}
+			rx_restart(rx);
+			return n;
+		}
+		if (b == PLI_FRAME_ESC) {
+			rx->escape = 1;
+			return 0;
+		}
+		if (rx->escape) {
+			b = b == PLI_FRAME_ESC_END ? PLI_FRAME_END : PLI_FRAME_ESC;
+			rx->escape = 0;
+		}
+	} else if (b == '\n' || b == '\r') {
+		// end of a text line
+		if (!rx->overflow && rx->len < size) {
+			memcpy(text, rx->buffer, rx->len);
+			text[rx->len] = 0;
+			n = rx->len;
+		}
+		rx_restart(rx);
+		return n;
+	}
+
+	if (rx->len < PLI_FRAME_MAX)
+		rx->buffer[rx->len++] = b;
+	else
+		rx->overflow = 1;	// silently ignore this almost endless message
+	return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef PLIBI_FRAME_H_
+#define PLIBI_FRAME_H_
+
+#include <stdint.h>
+
+/*
+ * Binary framing of the plib messages (PL_BINARY_FRAMES).
+ *
+ * The messages stay the same text messages, only their transport
+ * changes: a frame carries one message, SLIP framed (END 0xc0, ESC 0xdb)
+ * and protected by a CRC-16/CCITT (poly 0x1021, init 0xffff, sent big
+ * endian after the payload):
+ *
+ *   type [data...] crc_hi crc_lo END
+ *
+ * type is 0x80 for a message sent as text, or 0x81.. for a message of
+ * pli_frame_packed[]: its prefix is replaced by the type and its hex
+ * digits are sent as bytes, e.g. "d1" + 8 hex digits becomes 0x81 +
+ * 4 bytes. The rest of the message follows as text. Messages of
+ * variable length (telemetry, "dY") are packed as a whole: all their
+ * hex digits become bytes, there is no text after them.
+ *
+ * type is never a text character, so a receiver tells frames from
+ * text lines by their first byte and accepts both at any time. Each
+ * side sends frames only after the other side said it understands
+ * them (negotiated with the 'V' item), and falls back to text otherwise.
+ */
+
+#define PLI_FRAME_END 0xc0
+#define PLI_FRAME_ESC 0xdb
+#define PLI_FRAME_ESC_END 0xdc
+#define PLI_FRAME_ESC_ESC 0xdd
+#define PLI_FRAME_TEXT 0x80
+#define PLI_FRAME_TYPE_LAST 0xbf
+
+// longest text a packed message can have, see pli_frame_packed[]
+#define PLI_FRAME_HEAD 16
+
+#ifndef PLI_FRAME_MAX
+#define PLI_FRAME_MAX 40	// longest received frame or text line
+#endif
+
+uint16_t pli_crc16(uint16_t crc, uint8_t data);
+
+/*
+ * sender: messages are written char by char, '\n' ends a message.
+ * A message that does not fit into head is sent while it is written
+ * (as text or packed as a whole), so there is no length limit.
+ */
+typedef struct pli_frame_tx {
+    char head[PLI_FRAME_HEAD];
+    uint8_t len;            // chars in head
+    uint8_t streaming;      // head is sent, the rest goes out directly
+    uint8_t packing;        // streaming, digits are packed to bytes
+    uint8_t nibble;         // packing: 0x10 | first digit of a byte, 0 if none
+    uint16_t crc;
+} pli_frame_tx;
+
+void pli_frame_tx_init(pli_frame_tx* tx);
+
+void pli_frame_tx_put(pli_frame_tx* tx, char c);   // writes with pli_serial_write()
+
+/*
+ * receiver: bytes from the link, text lines or frames
+ */
+typedef struct pli_frame_rx {
+    uint8_t buffer[PLI_FRAME_MAX];
+    uint8_t len;
+    uint8_t frame;          // receiving a frame, else a text line
+    uint8_t escape;         // last byte was ESC
+    uint8_t overflow;       // too long, skipped up to its end
+    uint32_t errors;        // frames dropped: wrong crc, unknown type, too long
+} pli_frame_rx;
+
+void pli_frame_rx_init(pli_frame_rx* rx);
+
+/*
+ * returns the length of the message in text (0 terminated) when b
+ * completes one, 0 otherwise
+ */
+int pli_frame_rx_put(pli_frame_rx* rx, uint8_t b, char* text, int size);
+
+#endif
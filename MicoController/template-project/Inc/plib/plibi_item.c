@@ -0,0 +1,110 @@
+/*
+ * Registry of the items vPeripherals sets (see plibi_item.h)
+ */
+
+#include "plibi_item.h"
+#include "plib_config.h"
+#include "plibi_codec.h"
+
+#ifndef PL_ITEMS
+#define PL_ITEMS 24
+#endif
+
+#define ITEM_IDS 62	// '0'..'9', 'A'..'Z', 'a'..'z'
+#define SCREENS (PL_SCREEN_NONE + 1)
+
+typedef struct item {
+	pl_item_handler handler;
+	uint8_t type;
+} item;
+
+static item items[PL_ITEMS + 1];	// 0: no item
+static uint8_t items_used = 0;
+static uint8_t item_index[SCREENS][ITEM_IDS];
+static uint8_t screen_items[SCREENS];	// items registered per screen
+static uint8_t ready = 0;
+
+// hex digits of the fixed size types
+static const uint8_t hex_digits[] = { 2, 4, 8 };
+
+static int item_id(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'A' && c <= 'Z')
+		return c - 'A' + 10;
+	if (c >= 'a' && c <= 'z')
+		return c - 'a' + 36;
+	return -1;
+}
+
+static void setup() {
+	if (!ready) {
+		ready = 1;
+		pli_item_builtin();
+	}
+}
+
+int pl_item_register(uint8_t screen, char item_char, uint8_t type, pl_item_handler handler) {
+	int id = item_id(item_char);
+	uint8_t slot;
+
+	setup();
+	if (screen >= SCREENS || id < 0 || type > PL_ITEM_TEXT)
+		return -1;
+	// a removed item keeps its entry for the next handler
+	slot = item_index[screen][id];
+	if (!slot) {
+		if (!handler)
+			return 1;
+		if (items_used >= PL_ITEMS)
+			return -1;
+		slot = ++items_used;
+		item_index[screen][id] = slot;
+		screen_items[screen]++;
+	}
+	items[slot].handler = handler;
+	items[slot].type = type;
+	return 1;
+}
+
+int pli_item_dispatch(uint8_t screen, char item_char, const char *data, int len) {
+	int id = item_id(item_char);
+	pl_item_value value;
+	const item *it;
+	int result;
+
+	setup();
+	if (screen >= SCREENS || !screen_items[screen])
+		return PLI_ITEM_UNKNOWN_SCREEN;
+	if (id < 0)
+		return PLI_ITEM_UNKNOWN_ITEM;
+	it = &items[item_index[screen][id]];
+	if (!it->handler)
+		return PLI_ITEM_UNKNOWN_ITEM;
+
+	value.number = 0;
+	value.text = data;
+	value.len = len;
+	switch (it->type) {
+	case PL_ITEM_HEX8:
+	case PL_ITEM_HEX16:
+	case PL_ITEM_HEX32:
+		if (len != hex_digits[it->type])
+			return PL_ITEM_LENGTH;
+		if (!pli_hex_decode(data, len, &value.number))
+			return PL_ITEM_DECODE;
+		break;
+	case PL_ITEM_DEC:
+		if (len < 1 || len > 9)
+			return PL_ITEM_LENGTH;
+		if (!pli_dec_decode(data, len, &value.number))
+			return PL_ITEM_DECODE;
+		break;
+	default:
+		break;
+	}
+	result = it->handler(screen, item_char, &value);
+	if (result < PL_ITEM_OK || result > PL_ITEM_VALUE)
+		return PL_ITEM_VALUE;	// a handler of the app without a pl_item_result
+	return result;
+}
@@ -0,0 +1,33 @@
+#ifndef PLIBI_ITEM_H_
+#define PLIBI_ITEM_H_
+
+#include <stdint.h>
+#include "plib.h"
+
+/*
+ * Registry of the items vPeripherals sets (pl_item_register() in
+ * plib.h). Two tables make the lookup constant time: one index per
+ * screen and item id (62 ids: digits and letters), pointing to the
+ * handler and type of the item, 0 if none. The index costs
+ * 11 * 62 bytes, each of the PL_ITEMS entries 8 bytes.
+ */
+
+// results of pli_item_dispatch() besides enum pl_item_result, negative
+// so that no handler can return them
+#define PLI_ITEM_UNKNOWN_SCREEN -1	// no item registered for the screen
+#define PLI_ITEM_UNKNOWN_ITEM -2
+
+/*
+ * decodes len characters of data (0 terminated) by the type of item and
+ * calls its handler, returns its result (PL_ITEM_VALUE if it is no
+ * enum pl_item_result) or one of the above
+ */
+int pli_item_dispatch(uint8_t screen, char item, const char *data, int len);
+
+/*
+ * plib (plibi_main.c): registers its own items, called at the first use
+ * of the registry, so the app can replace them later
+ */
+void pli_item_builtin(void);
+
+#endif
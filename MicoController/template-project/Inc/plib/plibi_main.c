@@ -10,6 +10,19 @@
 #include "plib.h"
 #include "plibi_serial.h"
 #include "plib_config.h"
+#include "plib_profile.h"
+#include "plibi_timer.h"
+#include "plibi_rtc.h"
+#include "plibi_date.h"
+#include "plibi_noise.h"
+#include "plibi_codec.h"
+#include "plibi_item.h"
+#ifdef PL_ADC_DMA
+#include "plibi_adc.h"
+#endif
+#ifdef PL_BINARY_FRAMES
+#include "plibi_frame.h"
+#endif
 
 typedef uint32_t systick_t;
 extern volatile systick_t tick;
@@ -19,14 +32,46 @@ extern volatile systick_t tick;
  */
 #define MAX_READ_FROM_VISU 32
 
-typedef struct time_stamp_t {
-	uint16_t year;
-	uint8_t month;
-	uint8_t day;
-	uint8_t hour;
-	uint8_t min;
-	uint8_t sec;
-} time_stamp_t;
+#ifndef PL_DO_BYTES
+#define PL_DO_BYTES 64
+#endif
+#ifndef PL_DO_CYCLES
+#define PL_DO_CYCLES 0
+#endif
+#ifndef PL_FLUSH_TICKS
+#define PL_FLUSH_TICKS (PL_TICKS_PER_SECOND / 25)
+#endif
+#ifndef PL_PROFILE_TICKS
+#define PL_PROFILE_TICKS 5000
+#endif
+#ifndef PL_TELEMETRY_CHANNELS
+#define PL_TELEMETRY_CHANNELS 4
+#endif
+#ifndef PL_TELEMETRY_BUFFER_LEN
+#define PL_TELEMETRY_BUFFER_LEN 256
+#endif
+#ifndef PL_ADC_NOISE_AMPLITUDE
+#define PL_ADC_NOISE_AMPLITUDE 896
+#endif
+#ifndef PL_STDOUT_BUFFER_LEN
+#define PL_STDOUT_BUFFER_LEN 256
+#endif
+_Static_assert(PLI_QUEUE_POWER_OF_TWO(PL_STDOUT_BUFFER_LEN), "PL_STDOUT_BUFFER_LEN must be a power of two");
+#if defined PL_RX_CREDITS && !defined PL_RX_BUFFER_LEN
+#define PL_RX_BUFFER_LEN 256
+#endif
+
+// flags of '?V': what plib offers
+#ifdef PL_BINARY_FRAMES
+#define VERSION_FRAMES "b"
+#else
+#define VERSION_FRAMES ""
+#endif
+#ifdef PL_RX_CREDITS
+#define VERSION_FLAGS VERSION_FRAMES "c"
+#else
+#define VERSION_FLAGS VERSION_FRAMES
+#endif
 
 enum error_codes {
 	E_NONE = 0,
@@ -47,110 +92,319 @@ static uint8_t state_switch = 0;
 static uint8_t state_button = 0;
 static uint8_t state_led = 0;
 uint16_t state_adc[PL_NUMBER_ADCS];
+static pli_noise adc_noise = { PLI_NOISE_SEED, PL_ADC_NOISE_UNIFORM, PL_ADC_NOISE_AMPLITUDE };
+#if defined PL_ADC_DMA && !defined PL_HOST
+_Static_assert(PL_NUMBER_ADCS <= PLI_ADC_CHANNELS, "PA2 and PA3 are the link, see plibi_adc.h");
+static volatile uint16_t adc_samples[PL_NUMBER_ADCS];	// written by the DMA, see plibi_adc.h
+#endif
 
-static char screen = 0;
-static time_stamp_t time_current;
+/*
+ * input events, see pl_event_handler_set()
+ */
+#define EVENT_QUEUE_LEN 8	// events without handler, the oldest is dropped when full
+
+static pl_event_handler handlers[PL_EVENT_SOURCES];
+static pl_event events[EVENT_QUEUE_LEN];
+static uint8_t events_read = 0, events_count = 0;
+
+static void input_changed(uint8_t source, uint8_t channel, uint16_t previous,
+		uint16_t value) {
+	pl_event event;
+
+	if (value == previous)
+		return;	// nothing to do for the app
+	event.source = source;
+	event.channel = channel;
+	event.value = value;
+	event.previous = previous;
+	event.pressed = source == PL_EVENT_ADC ? 0 : value & ~previous;
+	event.released = source == PL_EVENT_ADC ? 0 : previous & ~value;
+
+	if (handlers[source]) {
+		handlers[source](&event);
+		return;
+	}
+	if (events_count == EVENT_QUEUE_LEN) {
+		events_read = (events_read + 1) % EVENT_QUEUE_LEN;
+		events_count--;
+	}
+	events[(events_read + events_count) % EVENT_QUEUE_LEN] = event;
+	events_count++;
+}
 
-static double random() {
-	// this gives random values in the range 0..1
-	double b;
-	const unsigned long a = 65539;
-	const unsigned long m = 2147483647;
-	static unsigned long xi = 7;
+/*
+ * link health, see pl_link_statistics_get()
+ */
+_Static_assert(E_VALUE == PL_LINK_ERROR_CODES, "an error code is not counted");
 
-	xi = (a * xi) % m;
-	b = (double) xi / (double) m;
-	return b;
-}
+static uint32_t link_errors[PL_LINK_ERROR_CODES];	// by error code - 1
+static uint32_t link_messages = 0;
+static uint64_t parse_sum = 0;
+static uint32_t parse_max = 0;
+static uint16_t rx_rate = 0, tx_rate = 0;
 
-static char hex_digit(int digit) {
-	return digit <= 9 ? '0' + digit : 'a' + digit - 10;
-}
+static char screen = 0;
 
-static void encode8(uint8_t s, char *d) {
-	// encode 8 bit to hex
-	*d++ = hex_digit(s >> 4);
-	*d++ = hex_digit(s & 0x0f);
-}
+/*
+ * outbound items: the app only overwrites the latest value (shadow),
+ * changed items are sent by flush() from pl_do(), at most every
+ * flush_ticks ticks and only as far as the tx queue has room. Fast
+ * writers neither flood the link nor wait in pli_serial_write().
+ */
+#define SHADOW_LEN 14	// longest packet: seesaw
+
+typedef struct shadow {
+	const char *prefix;
+	char packet[SHADOW_LEN];
+	uint8_t dirty;
+} shadow;
+
+enum shadow_items {
+	SHADOW_LED,
+	SHADOW_ALARMCLOCK,
+	SHADOW_SEESAW,
+	SHADOW_ITEMS
+};
 
-static void encode16(uint16_t s, char *d) {
-	// encode 16 bit to hex
-	for (int i = 0; i <= 1; i++) {
-		uint8_t b = s >> ((1 - i) * 8);
-		*d++ = hex_digit(b >> 4);
-		*d++ = hex_digit(b & 0x0f);
-	}
-}
+static shadow shadows[SHADOW_ITEMS] = {
+	{ "d00", "00", 0 },	// pl_init() announces the leds as off
+	{ "d1", "00000000", 0 },
+	{ "d2", "", 0 },
+};
 
-static void encode32(uint32_t s, char *d) {
-	// encode 32 bit to hex
-	for (int i = 0; i <= 3; i++) {
-		uint8_t b = s >> ((3 - i) * 8);
-		*d++ = hex_digit(b >> 4);
-		*d++ = hex_digit(b & 0x0f);
+static volatile systick_t tick_count = 0;	// counted by pl_tick()
+static volatile uint8_t ticking = 0;	// pl_tick() is called, otherwise there is no rate limit
+static systick_t flush_ticks = PL_FLUSH_TICKS;
+static systick_t last_flush = 0;
+static uint8_t flushing = 0;	// the last flush did not fit into the tx queue
+
+/*
+ * telemetry, see pl_telemetry_channel(): a sample is queued as its time
+ * (2 bytes, ticks) and the values of the channels in their types,
+ * big endian like all hex fields. pl_do() sends blocks
+ *   "dY" sequence (1 byte) dropped (2 bytes) samples...
+ * as hex, packed to bytes by the framing. dropped counts the samples
+ * lost since the previous block. Declarations are sent as
+ *   "dy" channel type name, type as letter of telemetry_code
+ */
+#define TELEMETRY_BLOCK 48	// bytes of samples in one block at most
+
+_Static_assert(PLI_QUEUE_POWER_OF_TWO(PL_TELEMETRY_BUFFER_LEN),
+		"PL_TELEMETRY_BUFFER_LEN must be a power of two");
+
+static const uint8_t telemetry_size[] = { 1, 2, 2, 4 };	// by pl_telemetry_type
+static const char telemetry_code[] = "bhHf";	// as in Python's struct
+static uint8_t telemetry_types[PL_TELEMETRY_CHANNELS];
+static const char *telemetry_names[PL_TELEMETRY_CHANNELS];
+static uint8_t telemetry_channels = 0;
+static uint8_t telemetry_len = 0;	// bytes per sample
+static uint16_t telemetry_every = 1, telemetry_skip = 0;
+static uint32_t telemetry_dropped = 0;
+static uint8_t telemetry_sequence = 0;
+static systick_t telemetry_last = 0;	// tick_count of the last block
+static uint8_t telemetry_buffer[PL_TELEMETRY_BUFFER_LEN];
+static pli_queue telemetry_queue;
+
+#ifndef PL_TX_BUFFER_LEN
+#define PL_TX_BUFFER_LEN 256
+#endif
+/*
+ * characters of one log message at most, longer lines are split: 64, or
+ * less if the tx buffer cannot take a framed line with every byte escaped
+ */
+#define STDOUT_FRAMED(len) (2 * (2 + (len) + 1 + 2) + 1)
+#define STDOUT_LINE ((PL_TX_BUFFER_LEN - 1) / 2 - 5 < 64 ? (PL_TX_BUFFER_LEN - 1) / 2 - 5 : 64)
+_Static_assert(STDOUT_LINE >= 16 && STDOUT_FRAMED(STDOUT_LINE) <= PL_TX_BUFFER_LEN,
+		"PL_TX_BUFFER_LEN is too small for a log message");
+
+// output of printf(), sent line by line as log messages by pl_do()
+static uint8_t stdout_buffer[PL_STDOUT_BUFFER_LEN];
+static pli_queue stdout_queue = {	// usable before pl_init(), e.g. by startup code
+	.mask = PL_STDOUT_BUFFER_LEN - 1,
+	.buffer = stdout_buffer
+};
+static uint32_t stdout_drops = 0;	// characters
+static char stdout_line[STDOUT_LINE + 1];
+static uint8_t stdout_line_len = 0;
+static uint8_t stdout_line_done = 0;	// waits for room in the tx buffer
+
+#ifdef PL_BINARY_FRAMES
+static pli_frame_tx frame_tx;
+static pli_frame_rx frame_rx;
+static uint8_t frames = 0;	// vPeripherals understands frames, see 'V'
+#endif
+
+#ifdef PL_RX_CREDITS
+/*
+ * Credits: vPeripherals sends no more bytes than plib grants, so the rx
+ * buffer never overflows. 'dC' carries the number of bytes (mod 0x10000)
+ * vPeripherals may have sent in total since its 'dV': the bytes plib has
+ * read since then plus PL_RX_BUFFER_LEN. The total is sent again when it
+ * has grown by half the buffer, and once per second in case it was lost.
+ */
+static uint8_t credits = 0;	// vPeripherals waits for credits, see 'V'
+static uint32_t rx_read = 0;	// bytes read by pl_do()
+static uint32_t rx_message_end = 0;	// rx_read at the end of the message handled
+static uint32_t credit_base = 0;	// rx_read at the end of 'dV'
+static uint16_t credit_limit = 0;	// sent last
+#endif
+
+static void send_char(char c) {
+#ifdef PL_BINARY_FRAMES
+	if (frames) {
+		pli_frame_tx_put(&frame_tx, c);
+		return;
 	}
+#endif
+	pli_serial_write(c);
 }
 
-static void send_string(char *prefix, char *data, int newline) {
+static void send_string(const char *prefix, const char *data, int newline) {
 	// write prefix and data to PC, optionally add a '\n'
 	if (prefix)
 		while (*prefix)
-			pli_serial_write(*prefix++);
+			send_char(*prefix++);
 	while (*data)
-		pli_serial_write(*data++);
+		send_char(*data++);
 	if (newline)
-		pli_serial_write('\n');
+		send_char('\n');
 }
 
 /*
- * Convert nr_digits in text from hex to int
- * Returns 0 on fail, positive on success
- *
+ * store the latest value of an item, returns 1 if it changed
  */
-static int from_hex(char *text, uint32_t *out, int nr_digits) {
-	uint32_t value = 0;
-	int valid = 1;
-
-	while (nr_digits && valid) {
-		if (((*text >= '0') && (*text <= '9'))
-				|| ((*text >= 'a') && (*text <= 'f'))) {
-			value = (value << 4)
-					+ (*text <= '9' ? *text - '0' : *text - 'a' + 10);
-			nr_digits--;
-			text++;
-		} else
-			valid = 0;
+static int shadow_set(uint8_t item, const char *packet) {
+	shadow *sh = &shadows[item];
+
+	if (strcmp(sh->packet, packet) == 0)
+		return 0;	// already sent or pending
+	strcpy(sh->packet, packet);
+	sh->dirty = 1;
+	return 1;
+}
+
+/*
+ * send the changed items; all: now and waiting for room in the tx queue
+ */
+static void flush(int all) {
+	shadow *sh;
+	int len;
+
+	if (!all && !flushing && ticking
+			&& (systick_t) (tick_count - last_flush) < flush_ticks)
+		return;
+	if (!flushing)
+		last_flush = tick_count;
+	flushing = 0;
+	for (sh = shadows; sh < shadows + SHADOW_ITEMS; sh++) {
+		if (!sh->dirty)
+			continue;
+		// room for the message even if framed and every byte escaped
+		len = strlen(sh->prefix) + strlen(sh->packet) + 1;
+		if (!all && pli_serial_tx_space() < 2 * len + 4) {
+			flushing = 1;	// the rest when the link has caught up
+			return;
+		}
+		sh->dirty = 0;
+		send_string((char*) sh->prefix, sh->packet, 1);
 	}
-	if (valid) {
-		*out = value;
-		return 1;
-	} else
-		return 0;
+}
+
+static void telemetry_announce(uint8_t channel) {
+	char packet[3];
+
+	packet[0] = '0' + channel;
+	packet[1] = telemetry_code[telemetry_types[channel]];
+	packet[2] = 0;
+	send_string("dy", packet, 0);
+	send_string(0, (char*) telemetry_names[channel], 1);
 }
 
 /*
- * Converts nr_digits in text from dec to int
- * Return 0 on fail, positive on success
- *
+ * send the buffered samples: full blocks, the rest after flush_ticks;
+ * all: everything now, waiting for room in the tx queue
  */
-static int from_dec(char *text, uint32_t *out, int nr_digits) {
-	uint32_t value = 0;
-	int valid = 1;
-
-	while (nr_digits && valid) {
-		if ((*text >= '0') && (*text <= '9')) {
-
-			value = value * 10 + *text - '0';
-			nr_digits--;
-			text++;
-		} else
-			valid = 0;
+static void telemetry_send(int all) {
+	uint8_t block[TELEMETRY_BLOCK];
+	char hex[2];
+	uint_fast16_t count, len;
+	uint32_t dropped;
+	int message;
+
+	if (!telemetry_len)
+		return;
+	while ((count = pli_queue_count(&telemetry_queue)) > 0) {
+		len = TELEMETRY_BLOCK / telemetry_len * telemetry_len;
+		if (count < len) {
+			if (!all && ticking
+					&& (systick_t) (tick_count - telemetry_last) < flush_ticks)
+				return;	// wait for more samples
+			len = count;
+		}
+		// room for the message: hex text, or packed with every byte escaped
+		message = 2 + 2 * (3 + len) + 1;
+#ifdef PL_BINARY_FRAMES
+		if (frames)
+			message = 2 * (1 + 3 + len + 2) + 1;
+#endif
+		if (!all && pli_serial_tx_space() < message)
+			return;
+		telemetry_last = tick_count;
+		len = pli_dequeue_bulk(&telemetry_queue, block, len);
+		dropped = __atomic_exchange_n(&telemetry_dropped, 0, __ATOMIC_RELAXED);
+		if (dropped > 0xffff)
+			dropped = 0xffff;
+
+		send_string("dY", "", 0);
+		pli_hex_encode8(telemetry_sequence++, hex);
+		send_char(hex[0]);
+		send_char(hex[1]);
+		pli_hex_encode8(dropped >> 8, hex);
+		send_char(hex[0]);
+		send_char(hex[1]);
+		pli_hex_encode8(dropped & 0xff, hex);
+		send_char(hex[0]);
+		send_char(hex[1]);
+		for (uint_fast16_t i = 0; i < len; i++) {
+			pli_hex_encode8(block[i], hex);
+			send_char(hex[0]);
+			send_char(hex[1]);
+		}
+		send_char('\n');
 	}
-	if (valid) {
-		*out = value;
-		return 1;
-	} else
-		return 0;
+}
+
+static void send_link_statistics(char item) {
+	pl_link_statistics st;
+	char packet[8 * (4 + PL_LINK_ERROR_CODES) + 1];
+	char *d = packet;
+
+	pl_link_statistics_get(&st);
+	if (item == 'Q') {
+		// transport: rates, bytes, losses, waits, buffer reserve
+		pli_hex_encode16(st.rx_rate, d);
+		pli_hex_encode16(st.tx_rate, d + 4);
+		pli_hex_encode32(st.rx_bytes, d + 8);
+		pli_hex_encode32(st.tx_bytes, d + 16);
+		pli_hex_encode32(st.overruns, d + 24);
+		pli_hex_encode32(st.drops, d + 32);
+		pli_hex_encode32(st.tx_waits, d + 40);
+		pli_hex_encode16(st.rx_min_free, d + 48);
+		pli_hex_encode16(st.tx_min_free, d + 52);
+		pli_hex_encode32(st.stdout_drops, d + 56);
+		d += 64;
+	} else {
+		// protocol: messages, parse time, errors
+		pli_hex_encode32(st.messages, d);
+		pli_hex_encode32(st.parse_mean, d + 8);
+		pli_hex_encode32(st.parse_max, d + 16);
+		pli_hex_encode32(st.frame_errors, d + 24);
+		d += 32;
+		for (int i = 0; i < PL_LINK_ERROR_CODES; i++, d += 8)
+			pli_hex_encode32(st.errors[i], d);
+	}
+	*d = 0;
+	send_string(item == 'Q' ? "dQ" : "dq", packet, 1);
 }
 
 static void send_screen() {
@@ -188,9 +442,21 @@ static enum error_codes incoming_request(char *msg, int len) {
 		response[1] = screen + '0';
 		response[2] = 0;
 		break;
+	case 'Q':	// link statistics, see send_link_statistics()
+	case 'q':
+		if (len)
+			return E_LENGTH;
+		send_link_statistics(item_id);
+		return E_NONE;
+	case 'y':	// telemetry channels, e.g. for a restarted vPeripherals
+		if (len)
+			return E_LENGTH;
+		for (uint8_t i = 0; i < telemetry_channels; i++)
+			telemetry_announce(i);
+		return E_NONE;
 	case '0':	// led, just for fun
 		response[0] = '0';
-		encode8(state_led, response + 1);
+		pli_hex_encode8(state_led, response + 1);
 		response[3] = 0;
 		break;
 	default:
@@ -202,175 +468,142 @@ static enum error_codes incoming_request(char *msg, int len) {
 	return E_NONE;
 }
 
-static enum error_codes incoming_setter_screen0(char *msg, int len) {
-	char item_id = msg[0];
-	int handled;
-	uint32_t value;
-
-	msg++;
-	len--;
-	switch (item_id) {
-	case '1':	// switch
-	case '2':	// button
-		// get a byte, store it
-		if (len != 2)
-			return E_LENGTH;
-		else {
-			handled = from_hex(msg, &value, 2);
-			if (handled) {
-				if (item_id == '1') {
-					state_switch = value & 0xff;
-				} else {
-					state_button = value & 0xff;
-				}
-			} else
-				return E_DECODE;	// decoding
-		}
-		break;
-
-	default:
-		if (('a' <= item_id) && (item_id < 'a' + PL_NUMBER_ADCS)) {
-			// get an analog value, store it
-			if (len != 4)
-				return E_LENGTH;	// length
-			else {
-				uint8_t channel = item_id - 'a';
-				handled = from_hex(msg, &value, 4);
-				if (handled) {
-					state_adc[channel] = value & 0xffff;
-				} else
-					return E_DECODE;
-			}
-		} else
-			return E_UNKNOWN_ITEM;
-	}
-	return E_NONE;
+#ifdef PL_RX_CREDITS
+/*
+ * send the credit for read bytes if it has grown by half the buffer, or always
+ */
+static void credit_grant(uint32_t read, int always) {
+	uint16_t limit = read - credit_base + PL_RX_BUFFER_LEN;
+	char text[5];
+
+	if (!credits)
+		return;
+	if (!always && (uint16_t) (limit - credit_limit) < PL_RX_BUFFER_LEN / 2)
+		return;
+	credit_limit = limit;
+	pli_hex_encode16(limit, text);
+	text[4] = 0;
+	send_string("dC", text, 1);
 }
+#endif
 
-static enum error_codes incoming_setter_screen_unnamed(char item_id, char *msg,
-		int len) {
-	uint32_t value;
-
-	switch (item_id) {
-	case 'T':
-		// get and process time string which is yyyymmddhhMMss
-		time_stamp_t ts;	// store incoming time stamp
+/*
+ * items of plib, registered at the first use of the registry (plibi_item.c)
+ */
+static int item_switch(uint8_t screen, char item, const pl_item_value *value) {
+	input_changed(PL_EVENT_SWITCH, 0, state_switch, value->number);
+	state_switch = value->number;
+	return PL_ITEM_OK;
+}
 
-		if (len != 14) {
-			return E_LENGTH;
-			break;
-		}
+static int item_button(uint8_t screen, char item, const pl_item_value *value) {
+	input_changed(PL_EVENT_BUTTON, 0, state_button, value->number);
+	state_button = value->number;
+	return PL_ITEM_OK;
+}
 
-		if (!from_dec(msg, &value, 4)) {
-			return E_DECODE;
-			break;
-		}
-		if ((value < 2000) || (value > 3000)) {
-			return E_VALUE;
-			break;
-		}
-		ts.year = value;
-		msg += 4;
+static int item_adc(uint8_t screen, char item, const pl_item_value *value) {
+	uint8_t channel = item - 'a';
 
-		if (!from_dec(msg, &value, 2)) {
-			return E_DECODE;
-			break;
-		}
-		if ((value < 1) || (value > 12)) {
-			return E_VALUE;
-			break;
-		}
-		ts.month = value;
-		msg += 2;
+	input_changed(PL_EVENT_ADC, channel, state_adc[channel], value->number);
+	state_adc[channel] = value->number;
+	return PL_ITEM_OK;
+}
 
-		if (!from_dec(msg, &value, 2)) {
-			return E_DECODE;
-			break;
-		}
-		if ((value < 1) || (value > 31)) {
-			return E_VALUE;
-			break;
-		}
-		ts.day = value;
-		msg += 2;
+static int item_time(uint8_t screen, char item, const pl_item_value *value) {
+	// time string yyyymmddhhMMss
+	const char *msg = value->text;
+	uint32_t year, month, day, hour, min, sec;
+	pl_time ts;
+
+	if (value->len != 14)
+		return PL_ITEM_LENGTH;
+	if (!(pli_dec_decode(msg, 4, &year) & pli_dec_decode(msg + 4, 2, &month)
+			& pli_dec_decode(msg + 6, 2, &day) & pli_dec_decode(msg + 8, 2, &hour)
+			& pli_dec_decode(msg + 10, 2, &min) & pli_dec_decode(msg + 12, 2, &sec)))
+		return PL_ITEM_DECODE;
+	ts.year = year;
+	ts.month = month;
+	ts.day = day;
+	ts.hour = hour;
+	ts.min = min;
+	ts.sec = sec;
+	ts.msec = 0;
+	// the date as a whole, e.g. no february 30th
+	if (!pli_date_valid(&ts))
+		return PL_ITEM_VALUE;
+	pli_rtc_set(&ts);
+	return PL_ITEM_OK;
+}
 
-		if (!from_dec(msg, &value, 2)) {
-			return E_DECODE;
-			break;
-		}
-		if ((value < 1) || (value > 23)) {
-			return E_VALUE;
-			break;
-		}
-		ts.hour = value;
-		msg += 2;
+static int item_baud(uint8_t screen, char item, const pl_item_value *value) {
+	// baud rate proposed by vPeripherals
+	if (value->len < 3 || value->len > 7)
+		return PL_ITEM_LENGTH;
+	if (!pli_serial_baud_valid(value->number))
+		return PL_ITEM_VALUE;
+	// acknowledge at the old rate, vPeripherals switches when it gets this
+	send_string("dB", value->text, 1);
+	pli_serial_set_baud(value->number);
+	return PL_ITEM_OK;
+}
 
-		if (!from_dec(msg, &value, 2)) {
-			return E_DECODE;
-			break;
-		}
-		if ((value < 1) || (value > 60)) {
-			return E_VALUE;
-			break;
-		}
-		ts.min = value;
-		msg += 2;
+static int item_version(uint8_t screen, char item, const pl_item_value *value) {
+	// version information of vPeripherals: 2 digits, flags, screens
+#ifdef PL_BINARY_FRAMES
+	if (memchr(value->text, 'b', value->len))
+		frames = 1;	// it reads frames from now on
+#endif
+#ifdef PL_RX_CREDITS
+	// it counts the bytes sent after this message, grant the first ones
+	credits = memchr(value->text, 'c', value->len) != 0;
+	credit_base = rx_message_end;
+	credit_grant(rx_message_end, 1);
+#endif
+	return PL_ITEM_OK;
+}
 
-		if (!from_dec(msg, &value, 2)) {
-			return E_DECODE;
-			break;
-		}
-		if ((value < 1) || (value > 60)) {
-			return E_VALUE;
-			break;
-		}
-		ts.sec = value;
-		msg += 2;
-		time_current = ts;
-		break;
-	case 'V':
-		// version information, for future use
-		// nothing to do at the moment
-		break;
-	default:
-		// invalid item
-		return E_UNKNOWN_ITEM;
-	}
-	return E_NONE;
+void pli_item_builtin(void) {
+	pl_item_register(0, '1', PL_ITEM_HEX8, item_switch);
+	pl_item_register(0, '2', PL_ITEM_HEX8, item_button);
+	for (int i = 0; i < PL_NUMBER_ADCS; i++)
+		pl_item_register(0, 'a' + i, PL_ITEM_HEX16, item_adc);
+	pl_item_register(PL_SCREEN_NONE, 'T', PL_ITEM_TEXT, item_time);
+	pl_item_register(PL_SCREEN_NONE, 'B', PL_ITEM_DEC, item_baud);
+	pl_item_register(PL_SCREEN_NONE, 'V', PL_ITEM_TEXT, item_version);
 }
 
+// results of a handler (enum pl_item_result) as sent to vPeripherals
+static const uint8_t item_errors[] = { E_NONE, E_LENGTH, E_DECODE, E_VALUE };
+
 static enum error_codes incoming_setter(char *msg, int len) {
-	// we got a set-packet from PC
-	char screen_item_id;
-	uint8_t error = E_NONE;
+	// we got a set-packet from PC: screen and item id, or an id of no screen
+	int result;
 
-	if (len < 1) {
-		error = E_LENGTH;	// too short, silently ignore this packet
-	} else {
-		screen_item_id = msg[0];
-		msg++;
-		len--;
-		// msg now points to the data after the screen_item_id
-		if (('0' <= screen_item_id) && (screen_item_id <= '9')) {
-			if (screen_item_id == '0') {
-				// screen 0: only button and switch to receive here
-				error = incoming_setter_screen0(msg, len);
-			} else {
-				error = E_UNKNOWN_SCREEN;
-			}
-		} else {
-			// screen_item_id is an id from the unnamed screen
-			error = incoming_setter_screen_unnamed(screen_item_id, msg, len);
-		}
-	}
-	return error;
+	if (len < 1)
+		return E_LENGTH;	// too short, silently ignore this packet
+	if (('0' <= msg[0]) && (msg[0] <= '9')) {
+		// msg[1] is the terminating 0 if there is no item id
+		if (len < 2)
+			result = pli_item_dispatch(msg[0] - '0', msg[1], msg + 1, 0);
+		else
+			result = pli_item_dispatch(msg[0] - '0', msg[1], msg + 2, len - 2);
+	} else
+		result = pli_item_dispatch(PL_SCREEN_NONE, msg[0], msg + 1, len - 1);
+	if (result == PLI_ITEM_UNKNOWN_SCREEN)
+		return E_UNKNOWN_SCREEN;
+	if (result == PLI_ITEM_UNKNOWN_ITEM)
+		return E_UNKNOWN_ITEM;
+	return item_errors[result];
 }
 
-static void incoming_from_visu(char *msg) {
+/*
+ * handle a message of len characters (0 terminated as well), as received
+ */
+static void incoming_from_visu(char *msg, int len) {
 	enum error_codes error = E_NONE;
 	char c = msg[0];
 	char *whole_msg = msg;
-	int_fast16_t len = strlen(msg);
 
 	if (c == 'd') {
 		error = incoming_setter(msg + 1, len - 1);// string to parse, len of string
@@ -385,53 +618,83 @@ static void incoming_from_visu(char *msg) {
 	}
 	if (error != E_NONE) {
 		char answer[] = "exx";
-		encode8(error, answer + 1);
+
+		link_errors[error - 1]++;
+		pli_hex_encode8(error, answer + 1);
 		send_string(answer, whole_msg, 1);
 	}
 }
 
-static int days_of_month(int year, int month) {
-	if (month == 2) {
-		if (((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0)) {
-			return 29;
-		} else {
-			return 28;
-		}
-	}
-
-	if ((month == 4) || (month == 6) || (month == 9) || (month == 11)) {
-		return 30;
-	}
-	return 31;
-}
-
-static void handle_1sec() {
-	if (++time_current.sec == 60) {
-		time_current.sec = 0;
-		if (++time_current.min == 60) {
-			time_current.min = 0;
-			if (++time_current.hour == 24) {
-				time_current.hour = 0;
-				if (++time_current.day
-						> days_of_month(time_current.month,
-								time_current.year)) {
-					time_current.day = 1;
-					if (++time_current.month >= 12) {
-						time_current.month = 1;
-						time_current.year++;
-					}
-				}
+/*
+ * send complete lines of printf() output while they fit into the tx buffer,
+ * all: everything, waiting for room
+ */
+static void stdout_send(int all) {
+	const uint8_t *data;
+	uint_fast16_t span, i;
+	int message;
+
+	while (1) {
+		// the next line, from the contiguous parts of the queue
+		while (!stdout_line_done && (span = pli_queue_span(&stdout_queue, &data)) > 0) {
+			if (span > (uint_fast16_t) (STDOUT_LINE - stdout_line_len))
+				span = STDOUT_LINE - stdout_line_len;
+			for (i = 0; i < span && !stdout_line_done; i++) {
+				if (data[i] == '\n')
+					stdout_line_done = 1;
+				else if (data[i] != '\r' && data[i] != 0)
+					stdout_line[stdout_line_len++] = data[i];
 			}
+			pli_queue_release(&stdout_queue, i);
+			if (stdout_line_len == STDOUT_LINE)
+				stdout_line_done = 1;
 		}
+		if (!stdout_line_done && !(all && stdout_line_len))
+			return;	// the rest of the line comes later
+		// room for the message, with every character escaped in a frame
+		message = 2 + stdout_line_len + 1;
+#ifdef PL_BINARY_FRAMES
+		if (frames)
+			message = STDOUT_FRAMED(stdout_line_len);
+#endif
+		if (!all && pli_serial_tx_space() < message)
+			return;
+		stdout_line[stdout_line_len] = 0;
+		send_string("dL", stdout_line, 1);
+		stdout_line_len = 0;
+		stdout_line_done = 0;
 	}
 }
 
+static void link_rates() {
+	static uint32_t rx_last = 0, tx_last = 0;
+	pli_serial_counters counters;
+
+	pli_serial_counters_read(&counters);
+	rx_rate = counters.rx_bytes - rx_last > 0xffff ? 0xffff : counters.rx_bytes - rx_last;
+	tx_rate = counters.tx_bytes - tx_last > 0xffff ? 0xffff : counters.tx_bytes - tx_last;
+	rx_last = counters.rx_bytes;
+	tx_last = counters.tx_bytes;
+}
+
 /*
  * global functions
  */
 void pl_init() {
 	pli_board_init();
+	pli_rtc_init();
+#if defined PL_ADC_DMA && !defined PL_HOST
+	pli_adc_start(adc_samples, PL_NUMBER_ADCS);
+#endif
 	pli_serial_init(PL_BAUD);
+#ifdef PL_BINARY_FRAMES
+	pli_frame_tx_init(&frame_tx);
+	pli_frame_rx_init(&frame_rx);
+#endif
+#if defined PL_BINARY_FRAMES || defined PL_RX_CREDITS
+	// ask vPeripherals if it reads frames ('b') and waits for credits ('c')
+	send_string(0, "?V" VERSION_FLAGS "\n", 0);
+#endif
 	pl_screen_set(0);	// set default screen and announce this to PC
 	send_string(0, "dS0\n?T\nd0000\n?01\n?02\n?0a\n?0b\n", 0); // request initial state + date and time
 	state = 1;
@@ -446,21 +709,17 @@ int pl_screen_set(uint8_t screen_p) {
 	}
 
 	screen = screen_p;
+	flush(1);	// values of the old screen first
 	send_screen();
 	return 1;
 }
 
 int pl_alarmclock_display(uint32_t display) {
-	static uint32_t old_display = 0;
 	char packet[9];
 
-	if (display == old_display)
-		return 0;
-	old_display = display;
-	encode32(display, packet);
+	pli_hex_encode32(display, packet);
 	packet[8] = 0;
-	send_string("d1", packet, 1);
-	return 1;
+	return shadow_set(SHADOW_ALARMCLOCK, packet);
 }
 
 int pl_seesaw_display(float reference, float position, float angle,
@@ -470,66 +729,285 @@ int pl_seesaw_display(float reference, float position, float angle,
 	char *destination = packet;
 
 	data = reference * 50000;
-	encode16((uint16_t) data, destination);
+	pli_hex_encode16((uint16_t) data, destination);
 	destination += 4;
 
 	data = position * 50000;
-	encode16((uint16_t) data, destination);
+	pli_hex_encode16((uint16_t) data, destination);
 	destination += 4;
 
 	data = angle * 2000;
-	encode16((uint16_t) data, destination);
+	pli_hex_encode16((uint16_t) data, destination);
 	destination += 4;
 
 	*destination++ = boing_state ? 't' : 'f';
 
 	*destination = 0;
 
-	send_string("d2", packet, 1);
+	shadow_set(SHADOW_SEESAW, packet);
 	return 1;
 }
 
-static void send_led() {
+int pl_led_set(uint8_t leds) {
 	char packet[] = "xx";
-	encode8(state_led, packet);
-	send_string("d00", packet, 1);
-}
 
-int pl_led_set(uint8_t leds) {
-	if (state_led == leds)
-		return 1;
 	state_led = leds;
-	send_led();
+	pli_hex_encode8(leds, packet);
+	shadow_set(SHADOW_LED, packet);
 	return 1;
 }
 
-void pl_do() {
-	static char message[MAX_READ_FROM_VISU + 1];
+void pl_flush_interval(uint16_t interval) {
+	flush_ticks = interval;
+}
+
+void pl_flush() {
+	flush(1);
+	telemetry_send(1);
+	stdout_send(1);
+}
+
+int pl_telemetry_channel(uint8_t channel, uint8_t type, const char *name) {
+	if (channel > telemetry_channels || channel >= PL_TELEMETRY_CHANNELS
+			|| type > PL_TELEMETRY_FLOAT)
+		return -1;
+	telemetry_types[channel] = type;
+	telemetry_names[channel] = name;
+	telemetry_channels = channel + 1;
+	telemetry_len = 2;
+	for (uint8_t i = 0; i < telemetry_channels; i++)
+		telemetry_len += telemetry_size[telemetry_types[i]];
+	pli_queue_init(&telemetry_queue, telemetry_buffer, sizeof(telemetry_buffer));
+	telemetry_dropped = 0;
+	telemetry_announce(channel);
+	return 1;
+}
+
+void pl_telemetry_decimation(uint16_t n) {
+	telemetry_every = n ? n : 1;
+	telemetry_skip = 0;
+}
+
+int pl_telemetry_sample(const float *values) {
+	uint8_t sample[2 + 4 * PL_TELEMETRY_CHANNELS];
+	uint8_t *d = sample;
+	systick_t now = tick_count;
+
+	if (!telemetry_len)
+		return -1;
+	if (++telemetry_skip < telemetry_every)
+		return 0;
+	telemetry_skip = 0;
+	if (pli_queue_space(&telemetry_queue) < telemetry_len) {
+		__atomic_fetch_add(&telemetry_dropped, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	*d++ = now >> 8;
+	*d++ = now & 0xff;
+	for (uint8_t i = 0; i < telemetry_channels; i++) {
+		float v = values[i];
+		int32_t n;
+		uint32_t bits;
+
+		switch (telemetry_types[i]) {
+		case PL_TELEMETRY_INT8:
+			n = v < -128.0f ? -128 : v > 127.0f ? 127 : (int32_t) (v + (v < 0 ? -0.5f : 0.5f));
+			*d++ = (uint8_t) n;
+			break;
+		case PL_TELEMETRY_INT16:
+			n = v < -32768.0f ? -32768 : v > 32767.0f ? 32767 : (int32_t) (v + (v < 0 ? -0.5f : 0.5f));
+			*d++ = (uint16_t) n >> 8;
+			*d++ = n & 0xff;
+			break;
+		case PL_TELEMETRY_UINT16:
+			n = v < 0.0f ? 0 : v > 65535.0f ? 65535 : (int32_t) (v + 0.5f);
+			*d++ = n >> 8;
+			*d++ = n & 0xff;
+			break;
+		default:
+			memcpy(&bits, &v, sizeof(bits));
+			*d++ = bits >> 24;
+			*d++ = bits >> 16;
+			*d++ = bits >> 8;
+			*d++ = bits & 0xff;
+		}
+	}
+	pli_enqueue_bulk(&telemetry_queue, sample, telemetry_len);
+	return 1;
+}
+
+/*
+ * collect a received byte, returns the length of message when it holds
+ * a complete one, 0 otherwise (empty lines are skipped)
+ */
+static int receive(uint8_t data, char *message) {
+#ifdef PL_BINARY_FRAMES
+	// text lines as well as frames
+	return pli_frame_rx_put(&frame_rx, data, message, MAX_READ_FROM_VISU + 1);
+#else
 	static uint_fast8_t message_pos = 0;
-	uint8_t data;
-
-	if (pli_serial_read(&data)) {
-		// got something to work on
-		if ((data == '\n') || (data == '\r')) {
-			message[message_pos] = 0;
-			message_pos = 0;
-			incoming_from_visu(message);
-		} else {
-			message[message_pos++] = data;
-			if (message_pos == MAX_READ_FROM_VISU) {
-				message[message_pos] = 0;
-				// silently ignore this almost endless PDU
+	static uint8_t too_long = 0;
+
+	if ((data == '\n') || (data == '\r')) {
+		int len = too_long ? 0 : message_pos;
+
+		message[message_pos] = 0;
+		message_pos = 0;
+		too_long = 0;
+		return len;
+	}
+	if (message_pos < MAX_READ_FROM_VISU)
+		message[message_pos++] = data;
+	else
+		too_long = 1;	// silently ignore this almost endless PDU
+	return 0;
+#endif
+}
+
+static uint16_t do_bytes = PL_DO_BYTES;
+static uint32_t do_cycles = PL_DO_CYCLES;
+
+void pl_do_budget(uint16_t bytes, uint32_t cycles) {
+	do_bytes = bytes ? bytes : 1;
+	do_cycles = cycles;
+}
+
+int pl_do() {
+	static systick_t rates_last = 0;
+	static char message[MAX_READ_FROM_VISU + 1];
+	uint8_t chunk[16];
+	uint32_t start = do_cycles ? pli_board_cycles() : 0;
+	int budget = do_bytes;
+	int handled = 0;
+	int n;
+
+	PL_PROFILE_BEGIN(pl_do);
+	// everything received, in chunks, until a budget is used up
+	while (budget > 0) {
+		n = pli_serial_read_bulk(chunk,
+				budget < (int) sizeof(chunk) ? budget : (int) sizeof(chunk));
+		if (n == 0)
+			break;
+		budget -= n;
+#ifdef PL_RX_CREDITS
+		rx_read += n;
+#endif
+		for (int i = 0; i < n; i++) {
+			int len = receive(chunk[i], message);
+
+			if (len > 0) {
+				uint32_t parse = pli_board_cycles();
+
+#ifdef PL_RX_CREDITS
+				rx_message_end = rx_read - n + i + 1;
+#endif
+
+				incoming_from_visu(message, len);
+				parse = pli_board_cycles() - parse;
+				parse_sum += parse;
+				if (parse > parse_max)
+					parse_max = parse;
+				link_messages++;
+				handled++;
 			}
 		}
+		if (do_cycles && pli_board_cycles() - start >= do_cycles)
+			break;
 	}
+	PL_PROFILE_END(pl_do);
+#ifdef PL_RX_CREDITS
+	credit_grant(rx_read, 0);
+#endif
+	pli_timer_run(tick_count);
+	if (ticking && (systick_t) (tick_count - rates_last) >= PL_TICKS_PER_SECOND) {
+		rates_last = tick_count;
+		link_rates();
+#ifdef PL_RX_CREDITS
+		credit_grant(rx_read, 1);
+#endif
+	}
+	flush(0);
+	telemetry_send(0);
+	stdout_send(0);
+#ifdef PL_PROFILING
+	static systick_t profile_last = 0;
+
+	if (ticking && (systick_t) (tick_count - profile_last) >= PL_PROFILE_TICKS) {
+		profile_last = tick_count;
+		pl_profile_report();
+	}
+#endif
+	return handled;
+}
+
+void pl_wait_event() {
+	flush(0);	// values set after pl_do()
+	telemetry_send(0);
+	pli_board_sleep_begin();
+	// sleep only if pl_do() has nothing to do
+	if (!pli_serial_rx_pending() && events_count == 0 && !pli_timer_due(tick_count))
+		pli_board_sleep();
+	pli_board_sleep_end();
 }
 
 void pl_tick() {
-	static systick_t divider_1sec = 0;
-	if (++divider_1sec >= PL_TICKS_PER_SECOND) {
-		divider_1sec -= PL_TICKS_PER_SECOND;
-		handle_1sec();
-	}
+	tick_count++;
+	ticking = 1;
+}
+
+uint32_t pl_ticks() {
+	return tick_count;
+}
+
+int pl_event_handler_set(uint8_t source, pl_event_handler handler) {
+	if (source >= PL_EVENT_SOURCES)
+		return -1;
+	handlers[source] = handler;
+	return 1;
+}
+
+int pl_event_get(pl_event *event) {
+	if (events_count == 0)
+		return 0;
+	*event = events[events_read];
+	events_read = (events_read + 1) % EVENT_QUEUE_LEN;
+	events_count--;
+	return 1;
+}
+
+void pl_link_statistics_get(pl_link_statistics *statistics) {
+	pli_serial_counters counters;
+
+	pli_serial_counters_read(&counters);
+	statistics->rx_bytes = counters.rx_bytes;
+	statistics->tx_bytes = counters.tx_bytes;
+	statistics->rx_rate = rx_rate;
+	statistics->tx_rate = tx_rate;
+	statistics->overruns = counters.overruns;
+	statistics->drops = counters.drops;
+	statistics->tx_waits = counters.tx_waits;
+	statistics->stdout_drops = stdout_drops;
+#ifdef PL_QUEUE_STATISTICS
+	int rx_free, tx_free;
+
+	pli_serial_statistics_read(&rx_free, &tx_free);
+	statistics->rx_min_free = rx_free;
+	statistics->tx_min_free = tx_free;
+#else
+	statistics->rx_min_free = 0;
+	statistics->tx_min_free = 0;
+#endif
+#ifdef PL_BINARY_FRAMES
+	statistics->frame_errors = frame_rx.errors;
+#else
+	statistics->frame_errors = 0;
+#endif
+	for (int i = 0; i < PL_LINK_ERROR_CODES; i++)
+		statistics->errors[i] = link_errors[i];
+	statistics->messages = link_messages;
+	statistics->parse_mean = link_messages ? parse_sum / link_messages : 0;
+	statistics->parse_max = parse_max;
 }
 
 // get state of the switches
@@ -544,12 +1022,23 @@ int pl_button_get(uint8_t *buttons) {
 	return 1;
 }
 
+#if defined PL_ADC_DMA && !defined PL_HOST
+// get value of a real adc
+int pl_adc_get(uint8_t channel, uint16_t *value) {
+	if (channel < PL_NUMBER_ADCS) {
+		*value = adc_samples[channel];
+		return 1;
+	}
+	return 0;
+}
+#else
 // get value of an virtual adc
 int pl_adc_get(uint8_t channel, uint16_t *value) {
-	int v;
-	v = random() * 7.0 - 3.5;
+	int32_t v;
+
 	if (channel < PL_NUMBER_ADCS) {
-		v += state_adc[channel];
+		// noise in 1/256 steps, rounded to steps
+		v = state_adc[channel] + ((pli_noise_next(&adc_noise) + 128) >> 8);
 		if (v < 0)
 			v = 0;
 		if (v > 1023)
@@ -559,6 +1048,35 @@ int pl_adc_get(uint8_t channel, uint16_t *value) {
 	}
 	return 0;
 }
+#endif
+
+int pl_adc_noise(uint8_t distribution, uint16_t amplitude) {
+	if (distribution > PL_ADC_NOISE_GAUSSIAN || amplitude > PL_ADC_NOISE_MAX)
+		return -1;
+	adc_noise.distribution = distribution;
+	adc_noise.amplitude = amplitude;
+	return 1;
+}
+
+int pl_stdout_write(const char *data, int len) {
+	// a write that does not fit is dropped as a whole, not cut
+	if (len > 0 && pli_queue_space(&stdout_queue) < (uint_fast16_t) len) {
+		stdout_drops += len;
+		return 0;
+	}
+	return pli_enqueue_bulk(&stdout_queue, (const uint8_t*) data, len);
+}
+
+#ifndef PL_HOST
+/*
+ * printf() and friends of newlib write here (weak in syscall.c)
+ */
+int _write(int file, char *ptr, int len) {
+	if (file == 1 || file == 2)	// stdout, stderr
+		pl_stdout_write(ptr, len);
+	return len;	// dropped output is no error of the stream
+}
+#endif
 
 // writes a log message to the visualization
 int pl_log(char *message) {
@@ -575,9 +1093,16 @@ int pl_log_debug(char *message) {
 	return 1;
 }
 
+void pl_time_get(pl_time *time) {
+	pli_rtc_get(time);
+}
+
 void pl_get_hms(int *h, int *m, int *s) {
-	*h = time_current.hour;
-	*m = time_current.min;
-	*s = time_current.sec;
+	pl_time time;
+
+	pli_rtc_get(&time);
+	*h = time.hour;
+	*m = time.min;
+	*s = time.sec;
 }
 
@@ -0,0 +1,48 @@
+/*
+ * Noise of the virtual adcs (see plibi_noise.h)
+ */
+
+#include "plibi_noise.h"
+#include "plib.h"
+
+#define GAUSSIAN_MEAN 510	// 4 * 255 / 2
+#define GAUSSIAN_SCALE 443	// 65536 / 147.8, the standard deviation of the sum
+
+void pli_noise_init(pli_noise *noise, uint8_t distribution, uint16_t amplitude) {
+	noise->state = PLI_NOISE_SEED;
+	noise->distribution = distribution;
+	noise->amplitude = amplitude;
+}
+
+static inline uint32_t xorshift32(pli_noise *noise) {
+	uint32_t x = noise->state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return noise->state = x;
+}
+
+int32_t pli_noise_next(pli_noise *noise) {
+	int32_t amplitude = noise->amplitude;
+	uint32_t r;
+	int32_t sum;
+
+	switch (noise->distribution) {
+	case PL_ADC_NOISE_UNIFORM:
+		// 16 bits * 15 bits stays below 2^31
+		r = xorshift32(noise) >> 16;
+		return (int32_t) ((r * (2 * amplitude + 1)) >> 16) - amplitude;
+	case PL_ADC_NOISE_TRIANGULAR:
+		r = xorshift32(noise);
+		sum = (r >> 16) + (r & 0xffff);
+		return (int32_t) (((uint32_t) sum * amplitude) >> 16) - amplitude;
+	case PL_ADC_NOISE_GAUSSIAN:
+		r = xorshift32(noise);
+		sum = (r >> 24) + (r >> 16 & 0xff) + (r >> 8 & 0xff) + (r & 0xff) - GAUSSIAN_MEAN;
+		// scale in two steps to stay within 32 bits
+		return (sum * ((amplitude * GAUSSIAN_SCALE) >> 8)) >> 8;
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef PLIBI_NOISE_H_
+#define PLIBI_NOISE_H_
+
+#include <stdint.h>
+
+/*
+ * Noise of the virtual adcs (pl_adc_noise() in plib.h). Pure integer
+ * arithmetic, also used by the benchmark.
+ *
+ * The random numbers come from xorshift32 (Marsaglia), three shifts and
+ * xors per number. The distributions are built from its 32 bits:
+ * - uniform: the upper 16 bits scaled to -amplitude..amplitude
+ * - triangular: the sum of both 16 bit halves, scaled the same way
+ * - gaussian: the sum of the four bytes, which is close to normal
+ *   (Irwin-Hall, mean 510, standard deviation 147.8), scaled so that
+ *   amplitude is one standard deviation
+ * Results are in 1/256 of an adc step.
+ */
+
+#define PLI_NOISE_SEED 2463534242UL	// seed of Marsaglia's paper
+
+typedef struct pli_noise {
+	uint32_t state;	// never 0
+	uint8_t distribution;	// enum pl_adc_noise_distribution
+	uint16_t amplitude;	// at most PL_ADC_NOISE_MAX
+} pli_noise;
+
+void pli_noise_init(pli_noise *noise, uint8_t distribution, uint16_t amplitude);
+
+/*
+ * the next noise value, 1/256 adc steps
+ */
+int32_t pli_noise_next(pli_noise *noise);
+
+#endif
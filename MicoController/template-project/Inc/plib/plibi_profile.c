@@ -0,0 +1,147 @@
+/*
+ * Profiling zones (see plib_profile.h)
+ */
+
+#include "plib_profile.h"
+
+#ifdef PL_PROFILING
+
+#include "plib.h"
+#include "plibi_board.h"
+
+#ifdef PL_HOST
+#include <pthread.h>
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static pl_profile_zone *zones = 0;
+
+/*
+ * zones are also used in interrupt handlers: no handler runs between
+ * lock() and unlock(). The host port only serializes linking, copies
+ * and resets with a mutex.
+ */
+static uint32_t lock(void) {
+#ifdef PL_HOST
+	pthread_mutex_lock(&mutex);
+	return 0;
+#else
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	return primask;
+#endif
+}
+
+static void unlock(uint32_t primask) {
+#ifdef PL_HOST
+	(void) primask;
+	pthread_mutex_unlock(&mutex);
+#else
+	__set_PRIMASK(primask);
+#endif
+}
+
+void pl_profile_add(pl_profile_zone *zone, uint32_t cycles) {
+	unsigned bin;
+
+	if (!zone->linked) {
+		// first use: link it, the list only grows
+		uint32_t primask = lock();
+
+		zone->next = zones;
+		zones = zone;
+		zone->linked = 1;
+		unlock(primask);
+	}
+	if (!zone->count)
+		zone->min = cycles;
+	zone->count++;
+	zone->sum += cycles;
+	if (cycles < zone->min)
+		zone->min = cycles;
+	if (cycles > zone->max)
+		zone->max = cycles;
+	// bins of powers of 4: floor(log2(cycles)) / 2
+	bin = cycles < 4 ? 0 : (31 - __builtin_clz(cycles)) / 2;
+	zone->histogram[bin < PL_PROFILE_BINS ? bin : PL_PROFILE_BINS - 1]++;
+}
+
+// the put functions write up to end, the rest is cut
+static char* put_number(char *d, char *end, uint32_t n) {
+	char digits[10];
+	int i = 0;
+
+	do {
+		digits[i++] = '0' + n % 10;
+		n /= 10;
+	} while (n);
+	while (i && d < end)
+		*d++ = digits[--i];
+	return d;
+}
+
+static char* put_text(char *d, char *end, const char *s) {
+	while (*s && d < end)
+		*d++ = *s++;
+	return d;
+}
+
+void pl_profile_report(void) {
+	// e.g. "loop n=1000 min=80 mean=95 max=300 cycles h=0,0,5,990,5,0,0,0"
+	char line[160];
+	char *end = line + sizeof(line) - 1;
+	char *d;
+	pl_profile_zone *zone, copy;
+	uint32_t primask;
+
+	primask = lock();
+	zone = zones;
+	unlock(primask);
+	for (; zone; zone = copy.next) {
+		// a consistent copy, the zone may be used by an interrupt handler
+		primask = lock();
+		copy = *zone;
+		unlock(primask);
+		if (!copy.count)
+			continue;
+		d = put_text(line, end, copy.name);
+		d = put_text(d, end, " n=");
+		d = put_number(d, end, copy.count);
+		d = put_text(d, end, " min=");
+		d = put_number(d, end, copy.min);
+		d = put_text(d, end, " mean=");
+		d = put_number(d, end, copy.sum / copy.count);
+		d = put_text(d, end, " max=");
+		d = put_number(d, end, copy.max);
+#ifdef PL_HOST
+		d = put_text(d, end, " ns h=");
+#else
+		d = put_text(d, end, " cycles h=");
+#endif
+		for (int i = 0; i < PL_PROFILE_BINS; i++) {
+			if (i)
+				d = put_text(d, end, ",");
+			d = put_number(d, end, copy.histogram[i]);
+		}
+		*d = 0;
+		pl_log_debug(line);
+	}
+}
+
+void pl_profile_reset(void) {
+	uint32_t primask = lock();
+
+	for (pl_profile_zone *zone = zones; zone; zone = zone->next) {
+		zone->count = 0;
+		zone->sum = 0;
+		zone->min = 0;
+		zone->max = 0;
+		for (int i = 0; i < PL_PROFILE_BINS; i++)
+			zone->histogram[i] = 0;
+	}
+	unlock(primask);
+}
+
+#endif
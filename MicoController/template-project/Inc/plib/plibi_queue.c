@@ -2,66 +2,144 @@
  * Implementation of a queue data structure, used for buffering data for
  * serial communication (UART)
  *
+ * The indices are shared between an interrupt handler and the main
+ * loop. Each side publishes its own index with release semantics after
+ * touching the buffer and reads the other index with acquire semantics,
+ * so the data is visible before the index says so.
  */
 
+#include <string.h>
+
 #include "plibi_queue.h"
 
+#define LOAD_OWN(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define LOAD_OTHER(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define PUBLISH(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
 
 #ifdef PL_QUEUE_STATISTICS
 int pli_queue_statistics_free(pli_queue* q){
-    int free=q->read - q->write - 1;
-    if (free < 0) free += q->size;
-    return free;
+    return pli_queue_space(q);
 }
 
 void pli_queue_statistics_reset(pli_queue* q){
-    q->min=q->size-1;
+    q->min=q->mask+1;
+}
+
+static void statistics_update(pli_queue* q, uint_fast16_t space){
+    if (space < q->min) q->min=space;
 }
+#else
+#define statistics_update(q, space)
 #endif
 
 void pli_queue_init(pli_queue* q, uint8_t* buffer, uint_fast16_t size)
 {
+    while (!PLI_QUEUE_POWER_OF_TWO(size))
+        size &= size - 1;   // clear lowest bit until one is left
     q->read = q->write = 0;
-    q->size = size;
+    q->mask = size - 1;
     q->buffer = buffer;
 #ifdef PL_QUEUE_STATISTICS
     pli_queue_statistics_reset(q);
 #endif
 }
 
+uint_fast16_t pli_queue_count(pli_queue* q)
+{
+    return LOAD_OTHER(&q->write) - LOAD_OWN(&q->read);
+}
+
+uint_fast16_t pli_queue_space(pli_queue* q)
+{
+    return q->mask + 1 - (LOAD_OWN(&q->write) - LOAD_OTHER(&q->read));
+}
+
 int pli_queue_full(pli_queue* q)
 {
-    return (((q->write + 1) % q->size) == q->read);
+    return pli_queue_space(q) == 0;
 }
 
 int pli_queue_empty(pli_queue* q)
 {
-    return (q->write == q->read);
+    return pli_queue_count(q) == 0;
 }
 
 int pli_enqueue(pli_queue* q, uint8_t data)
 {
-    if (pli_queue_full(q))
-        return 0;
-    else {
-        q->buffer[q->write] = data;
-        q->write = ((q->write + 1) == q->size) ? 0 : q->write + 1;
-#ifdef PL_QUEUE_STATISTICS
-        uint_fast16_t min=pli_queue_statistics_free(q);
-        if (min < q->min) q->min=min;
-#endif
+    uint_fast16_t write = LOAD_OWN(&q->write);
+    uint_fast16_t space = q->mask + 1 - (write - LOAD_OTHER(&q->read));
 
-    }
+    if (space == 0)
+        return 0;
+    q->buffer[write & q->mask] = data;
+    PUBLISH(&q->write, write + 1);
+    statistics_update(q, space - 1);
     return 1;
 }
 
 int pli_dequeue(pli_queue* q, uint8_t* data)
 {
-    if (pli_queue_empty(q))
+    uint_fast16_t read = LOAD_OWN(&q->read);
+
+    if (LOAD_OTHER(&q->write) == read)
         return 0;
-    else {
-        *data = q->buffer[q->read];
-        q->read = ((q->read + 1) == q->size) ? 0 : q->read + 1;
-    }
+    *data = q->buffer[read & q->mask];
+    PUBLISH(&q->read, read + 1);
     return 1;
 }
+
+uint_fast16_t pli_enqueue_bulk(pli_queue* q, const uint8_t* data, uint_fast16_t len)
+{
+    uint_fast16_t write = LOAD_OWN(&q->write);
+    uint_fast16_t space = q->mask + 1 - (write - LOAD_OTHER(&q->read));
+    uint_fast16_t pos = write & q->mask;
+    uint_fast16_t first;
+
+    if (len > space)
+        len = space;
+    // at most two spans: up to the end of the buffer and from its start
+    first = q->mask + 1 - pos;
+    if (first > len)
+        first = len;
+    memcpy(q->buffer + pos, data, first);
+    memcpy(q->buffer, data + first, len - first);
+    PUBLISH(&q->write, write + len);
+    statistics_update(q, space - len);
+    return len;
+}
+
+uint_fast16_t pli_dequeue_bulk(pli_queue* q, uint8_t* data, uint_fast16_t len)
+{
+    uint_fast16_t read = LOAD_OWN(&q->read);
+    uint_fast16_t count = LOAD_OTHER(&q->write) - read;
+    uint_fast16_t pos = read & q->mask;
+    uint_fast16_t first;
+
+    if (len > count)
+        len = count;
+    first = q->mask + 1 - pos;
+    if (first > len)
+        first = len;
+    memcpy(data, q->buffer + pos, first);
+    memcpy(data + first, q->buffer, len - first);
+    PUBLISH(&q->read, read + len);
+    return len;
+}
+
+uint_fast16_t pli_queue_span(pli_queue* q, const uint8_t** data)
+{
+    uint_fast16_t read = LOAD_OWN(&q->read);
+    uint_fast16_t count = LOAD_OTHER(&q->write) - read;
+    uint_fast16_t pos = read & q->mask;
+
+    *data = q->buffer + pos;
+    // up to the end of the buffer, the rest follows with the next span
+    if (count > q->mask + 1 - pos)
+        count = q->mask + 1 - pos;
+    return count;
+}
+
+void pli_queue_release(pli_queue* q, uint_fast16_t len)
+{
+    PUBLISH(&q->read, LOAD_OWN(&q->read) + len);
+}
@@ -5,29 +5,68 @@
 
 #include "plib_config.h"
 
+/*
+ * Single producer, single consumer ring buffer of bytes.
+ * One side may run in an interrupt handler, the other one in the
+ * main loop; no locks are needed as long as each side only calls its
+ * own functions:
+ * - producer: pli_enqueue(), pli_enqueue_bulk(), pli_queue_space()
+ * - consumer: pli_dequeue(), pli_dequeue_bulk(), pli_queue_count(),
+ *   pli_queue_span(), pli_queue_release()
+ *
+ * read and write run freely and are masked on access, so size must be
+ * a power of two. All size places can be used.
+ */
 typedef struct pli_queue {
-    uint_fast16_t read, write;
-    uint_fast16_t size;
+    uint_fast16_t read;     // written by the consumer only
+    uint_fast16_t write;    // written by the producer only
+    uint_fast16_t mask;     // size - 1
     uint8_t* buffer;
 #ifdef PL_QUEUE_STATISTICS
     uint_fast16_t min;
 #endif
 } pli_queue;
 
+#define PLI_QUEUE_POWER_OF_TWO(size) ((size) > 0 && ((size) & ((size) - 1)) == 0)
+
 #ifdef PL_QUEUE_STATISTICS
 int pli_queue_statistics_free(pli_queue* q);
 
 void pli_queue_statistics_reset(pli_queue* q);
 #endif
 
+/*
+ * size must be a power of two, otherwise only the largest
+ * power of two below size is used
+ */
 void pli_queue_init(pli_queue* q, uint8_t* buffer, uint_fast16_t size);
 
 int pli_queue_full(pli_queue* q);
 
 int pli_queue_empty(pli_queue* q);
 
+uint_fast16_t pli_queue_count(pli_queue* q);   // bytes to dequeue
+
+uint_fast16_t pli_queue_space(pli_queue* q);   // bytes to enqueue
+
 int pli_enqueue(pli_queue* q, uint8_t data);
 
 int pli_dequeue(pli_queue* q, uint8_t* data);
 
+/*
+ * copy up to len bytes, returns the number of bytes copied
+ */
+uint_fast16_t pli_enqueue_bulk(pli_queue* q, const uint8_t* data, uint_fast16_t len);
+
+uint_fast16_t pli_dequeue_bulk(pli_queue* q, uint8_t* data, uint_fast16_t len);
+
+/*
+ * dequeue without copying, e.g. for DMA: pli_queue_span() returns the
+ * number of contiguous bytes at *data, pli_queue_release() removes
+ * len of them once they are no longer needed
+ */
+uint_fast16_t pli_queue_span(pli_queue* q, const uint8_t** data);
+
+void pli_queue_release(pli_queue* q, uint_fast16_t len);
+
 #endif
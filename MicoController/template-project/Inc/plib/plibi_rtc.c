@@ -0,0 +1,139 @@
+/*
+ * Wall clock from the RTC of the STM32H533 (see plibi_rtc.h)
+ *
+ * The calendar runs in BCD with 24 hours from the LSE crystal of the
+ * Nucleo board (32.768 kHz), divided by 128 (PREDIV_A) and 256
+ * (PREDIV_S) to 1 Hz. The sub-second register counts PREDIV_S down to 0
+ * within each second. Without a crystal the LSI (32 kHz) is used, less
+ * precise. The RTC sits in the backup domain, so it keeps time over a
+ * reset of the core.
+ */
+
+#include "plibi_rtc.h"
+#include "plibi_board.h"
+#include "plibi_date.h"
+#include "system_stm32h5xx.h"
+
+#define LSE_PREDIV_S 255	// 32768 / 128 / 256 = 1 Hz
+#define LSI_PREDIV_S 249	// 32000 / 128 / 250 = 1 Hz
+#define PREDIV_A 127
+
+static uint32_t prediv_s = LSE_PREDIV_S;
+
+static inline uint32_t to_bcd(unsigned n) {
+	return (n / 10) << 4 | n % 10;
+}
+
+static inline unsigned from_bcd(uint32_t bcd) {
+	return (bcd >> 4) * 10 + (bcd & 0xf);
+}
+
+static void unlock() {
+	RTC->WPR = 0xca;
+	RTC->WPR = 0x53;
+}
+
+static void lock() {
+	RTC->WPR = 0xff;
+}
+
+// calendar stops, TR, DR and PRER are writable
+static void init_enter() {
+	SET_BIT(RTC->ICSR, RTC_ICSR_INIT);
+	while (!READ_BIT(RTC->ICSR, RTC_ICSR_INITF))
+		;
+}
+
+// calendar runs, the shadow registers follow again
+static void init_exit() {
+	CLEAR_BIT(RTC->ICSR, RTC_ICSR_INIT);
+	CLEAR_BIT(RTC->ICSR, RTC_ICSR_RSF);
+	while (!READ_BIT(RTC->ICSR, RTC_ICSR_RSF))
+		;
+}
+
+// selects the clock of the RTC, returns PREDIV_S for it
+static uint32_t clock_start() {
+	uint32_t start = pli_board_cycles();
+
+	// the crystal takes up to 2 s to start
+	SET_BIT(RCC->BDCR, RCC_BDCR_LSEON);
+	while (!READ_BIT(RCC->BDCR, RCC_BDCR_LSERDY)) {
+		if (pli_board_cycles() - start > 2 * SystemCoreClock) {
+			CLEAR_BIT(RCC->BDCR, RCC_BDCR_LSEON);
+			SET_BIT(RCC->BDCR, RCC_BDCR_LSION);
+			while (!READ_BIT(RCC->BDCR, RCC_BDCR_LSIRDY))
+				;
+			MODIFY_REG(RCC->BDCR, RCC_BDCR_RTCSEL, RCC_BDCR_RTCSEL_1);
+			return LSI_PREDIV_S;
+		}
+	}
+	MODIFY_REG(RCC->BDCR, RCC_BDCR_RTCSEL, RCC_BDCR_RTCSEL_0);
+	return LSE_PREDIV_S;
+}
+
+void pli_rtc_init(void) {
+	volatile uint32_t tmp;
+	pl_time start = { 2000, 1, 1, 0, 0, 0, 0 };
+
+	SET_BIT(RCC->APB3ENR, RCC_APB3ENR_RTCAPBEN);
+	/* Delay after an RCC peripheral clock enabling */
+	tmp = READ_BIT(RCC->APB3ENR, RCC_APB3ENR_RTCAPBEN);
+	UNUSED(tmp);
+
+	// the backup domain is write protected after reset
+	SET_BIT(PWR->DBPCR, PWR_DBPCR_DBP);
+	while (!READ_BIT(PWR->DBPCR, PWR_DBPCR_DBP))
+		;
+
+	if (READ_BIT(RCC->BDCR, RCC_BDCR_RTCEN) && READ_BIT(RTC->ICSR, RTC_ICSR_INITS)) {
+		// still running since before the reset
+		prediv_s = READ_BIT(RTC->PRER, RTC_PRER_PREDIV_S_Msk);
+		unlock();
+		CLEAR_BIT(RTC->ICSR, RTC_ICSR_RSF);
+		while (!READ_BIT(RTC->ICSR, RTC_ICSR_RSF))
+			;
+		lock();
+		return;
+	}
+
+	prediv_s = clock_start();
+	SET_BIT(RCC->BDCR, RCC_BDCR_RTCEN);
+	unlock();
+	init_enter();
+	// two writes, PREDIV_S first
+	RTC->PRER = prediv_s;
+	RTC->PRER = prediv_s | PREDIV_A << RTC_PRER_PREDIV_A_Pos;
+	CLEAR_BIT(RTC->CR, RTC_CR_FMT | RTC_CR_BYPSHAD);	// 24 hours, read through the shadow registers
+	init_exit();
+	lock();
+	pli_rtc_set(&start);
+}
+
+void pli_rtc_set(const pl_time *time) {
+	unlock();
+	init_enter();
+	RTC->TR = to_bcd(time->hour) << RTC_TR_HU_Pos | to_bcd(time->min) << RTC_TR_MNU_Pos
+			| to_bcd(time->sec) << RTC_TR_SU_Pos;
+	RTC->DR = to_bcd(time->year - 2000) << RTC_DR_YU_Pos
+			| (uint32_t) pli_date_weekday(time) << RTC_DR_WDU_Pos
+			| to_bcd(time->month) << RTC_DR_MU_Pos | to_bcd(time->day) << RTC_DR_DU_Pos;
+	init_exit();
+	lock();
+}
+
+void pli_rtc_get(pl_time *time) {
+	// reading SSR freezes TR and DR until DR is read, all three belong together
+	uint32_t ssr = RTC->SSR;
+	uint32_t tr = RTC->TR;
+	uint32_t dr = RTC->DR;
+
+	time->hour = from_bcd((tr & (RTC_TR_HT_Msk | RTC_TR_HU_Msk)) >> RTC_TR_HU_Pos);
+	time->min = from_bcd((tr & (RTC_TR_MNT_Msk | RTC_TR_MNU_Msk)) >> RTC_TR_MNU_Pos);
+	time->sec = from_bcd((tr & (RTC_TR_ST_Msk | RTC_TR_SU_Msk)) >> RTC_TR_SU_Pos);
+	time->year = 2000 + from_bcd((dr & (RTC_DR_YT_Msk | RTC_DR_YU_Msk)) >> RTC_DR_YU_Pos);
+	time->month = from_bcd((dr & (RTC_DR_MT_Msk | RTC_DR_MU_Msk)) >> RTC_DR_MU_Pos);
+	time->day = from_bcd((dr & (RTC_DR_DT_Msk | RTC_DR_DU_Msk)) >> RTC_DR_DU_Pos);
+	// the sub-seconds count down, a shift may leave them above prediv_s for a moment
+	time->msec = ssr > prediv_s ? 0 : (prediv_s - ssr) * 1000 / (prediv_s + 1);
+}
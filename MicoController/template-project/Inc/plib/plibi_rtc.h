@@ -0,0 +1,29 @@
+#ifndef PLIBI_RTC_H_
+#define PLIBI_RTC_H_
+
+#include "plib.h"
+
+/*
+ * Wall clock of plib (pl_time_get()): the calendar of the RTC on the
+ * board, which counts by itself from the 32.768 kHz LSE, the system's
+ * monotonic clock on the host (plibi_rtc_host.c). No cpu time is spent
+ * per tick, a read costs a few register accesses.
+ */
+
+/*
+ * starts the clock at 2000-01-01 00:00:00, unless the RTC kept running
+ * over a reset
+ */
+void pli_rtc_init(void);
+
+/*
+ * sets the clock to a valid time (pli_date_valid()), msec is ignored
+ */
+void pli_rtc_set(const pl_time *time);
+
+/*
+ * reads the clock, with milliseconds
+ */
+void pli_rtc_get(pl_time *time);
+
+#endif
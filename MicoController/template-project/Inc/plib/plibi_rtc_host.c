@@ -0,0 +1,43 @@
+/*
+ * Wall clock for running a plib application as a Linux process
+ * (PL_HOST). Replaces plibi_rtc.c: the time set last plus the
+ * monotonic clock of the system since then.
+ */
+
+#ifdef PL_HOST
+
+#include <time.h>
+
+#include "plibi_rtc.h"
+#include "plibi_date.h"
+
+static uint32_t base = 0;	// seconds since 2000 at set
+static struct timespec set_at;
+
+void pli_rtc_init(void) {
+	base = 0;
+	clock_gettime(CLOCK_MONOTONIC, &set_at);
+}
+
+void pli_rtc_set(const pl_time *time) {
+	base = pli_date_to_seconds(time);
+	clock_gettime(CLOCK_MONOTONIC, &set_at);
+}
+
+void pli_rtc_get(pl_time *time) {
+	struct timespec now;
+	long nsec;
+	uint32_t seconds;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	seconds = now.tv_sec - set_at.tv_sec;
+	nsec = now.tv_nsec - set_at.tv_nsec;
+	if (nsec < 0) {
+		nsec += 1000000000L;
+		seconds--;
+	}
+	pli_date_from_seconds(base + seconds, time);
+	time->msec = nsec / 1000000L;
+}
+
+#endif
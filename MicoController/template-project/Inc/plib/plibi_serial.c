@@ -6,17 +6,26 @@
 #include "plibi_serial.h"
 
 #include "plib_config.h"
+#include "plib_profile.h"
 #if defined PL_TX_BUSY_LED
 	#include "plibi_board.h"
 #endif
 
 #include "stm32h5xx.h"
+#include "plibi_baud.h"
+
+#if defined PL_SERIAL_TX_DMA || defined PL_SERIAL_RX_DMA
+#include "plibi_dma.h"
+#endif
 
 #define UART_CR1_TXEIE (1<<7)
 #define UART_CR1_RXNEIE (1<<5)
 #define UART_ISR_ORE (1<<3)
 #define UART_ISR_RXNE (1<<5)
 #define UART_ISR_TXE (1<<7)
+#define UART_ISR_TC (1<<6)
+#define UART_ISR_IDLE (1<<4)
+#define UART_CR1_IDLEIE (1<<4)
 
 #ifndef PL_RX_BUFFER_LEN
 #warning "PL_RX_BUFFER_LEN is not defined, use default value"
@@ -29,11 +38,27 @@
 
 static USART_TypeDef *uart = USART2;
 
+_Static_assert(PLI_QUEUE_POWER_OF_TWO(PL_RX_BUFFER_LEN), "PL_RX_BUFFER_LEN must be a power of two");
+_Static_assert(PLI_QUEUE_POWER_OF_TWO(PL_TX_BUFFER_LEN), "PL_TX_BUFFER_LEN must be a power of two");
+
 static uint8_t rx_buffer[PL_RX_BUFFER_LEN];
 static uint8_t tx_buffer[PL_TX_BUFFER_LEN];
 
 static pli_queue rx_queue, tx_queue;
 
+#ifdef PL_SERIAL_RX_DMA
+#ifndef PL_RX_DMA_LEN
+#define PL_RX_DMA_LEN 64
+#endif
+static uint8_t rx_ring[PL_RX_DMA_LEN];	// written by DMA
+#endif
+
+static uint32_t overruns;	// bytes lost in the receiver (ORE)
+#ifndef PL_SERIAL_RX_DMA
+static uint32_t drops;		// received bytes lost because rx_queue was full
+#endif
+static uint32_t tx_waits, rx_bytes, tx_bytes;	// see pli_serial_counters
+
 static int tx_primed = 0;
 
 #if defined PL_TX_BUSY_LED
@@ -44,16 +69,30 @@ static uint8_t led_primed=0;
  * interrupt handler for our serial controller
  */
 void USART2_IRQHandler(void) {
+#if !defined PL_SERIAL_RX_DMA || !defined PL_SERIAL_TX_DMA
 	uint8_t b;
+#endif
+	PL_PROFILE_BEGIN(usart2_irq);
 	if (uart->ISR & UART_ISR_ORE) {
-		// receiver overflow
+		// receiver overflow, at least one byte is lost
 		uart->ICR = UART_ISR_ORE;
+		overruns++;
 	}
+#ifdef PL_SERIAL_RX_DMA
+	if (uart->ISR & UART_ISR_IDLE) {
+		// end of a burst: hand over what DMA received so far
+		uart->ICR = UART_ISR_IDLE;
+		pli_dma_rx_poll();
+	}
+#else
 	while (uart->ISR & UART_ISR_RXNE) {
 		// receiver buffer not empty
 		b = uart->RDR;
-		pli_enqueue(&rx_queue, b);
+		if (!pli_enqueue(&rx_queue, b))
+			drops++;
 	}
+#endif
+#ifndef PL_SERIAL_TX_DMA
 	if (uart->ISR & UART_ISR_TXE) {
 		// transmitter buffer  empty
 		if (pli_dequeue(&tx_queue, &b)) {
@@ -67,15 +106,35 @@ void USART2_IRQHandler(void) {
 #endif
 		}
 	}
+#endif
+	PL_PROFILE_END(usart2_irq);
+}
+
+/*
+ * kernel clock of USART2: pclk1, selected in pli_serial_init()
+ */
+static uint32_t kernel_clock(void) {
+	return SystemCoreClock
+			>> APBPrescTable[(RCC->CFGR2 & RCC_CFGR2_PPRE1) >> RCC_CFGR2_PPRE1_Pos];
+}
+
+/*
+ * program BRR and OVER8, the usart must be disabled
+ */
+static void baud_set(const pli_baud *setting) {
+	MODIFY_REG(uart->CR1, USART_CR1_OVER8,
+			setting->over8 ? USART_CR1_OVER8 : 0);
+	uart->BRR = setting->brr;
 }
 
 int pli_serial_init(uint32_t baud) {
 	static int first_run = 1;
 	volatile uint32_t tmp;
+	pli_baud setting;
 
 	if (!first_run)
 		return -1; // error: already initialized
-	if ((baud < 100) || (baud > 115200))
+	if (!pli_baud_compute(kernel_clock(), baud, &setting))
 		return -2;	// error: invalid baud rate
 
 	first_run = 0;
@@ -114,7 +173,7 @@ int pli_serial_init(uint32_t baud) {
 	MODIFY_REG(USART2->CR1, 1, 0);
 
 	MODIFY_REG(USART2->CR1, 0, 0x000c); // enable rx and tx
-	USART2->BRR = 1563; // clock is 15 000 000 Hz / 9600 (baud) = 1562,5
+	baud_set(&setting);	// e.g. pclk1 15 000 000 Hz / 9600 (baud) = 1563
 
 	/* In asynchronous mode, the following bits must be kept cleared:
 	 - LINEN and CLKEN bits in the USART_CR2 register,
@@ -122,11 +181,31 @@ int pli_serial_init(uint32_t baud) {
 	CLEAR_BIT(USART2->CR2, (USART_CR2_LINEN | USART_CR2_CLKEN));
 	CLEAR_BIT(USART2->CR3, (USART_CR3_SCEN | USART_CR3_HDSEL | USART_CR3_IREN));
 
+#if defined PL_SERIAL_TX_DMA || defined PL_SERIAL_RX_DMA
+	pli_dma_init();
+#endif
+#ifdef PL_SERIAL_RX_DMA
+	// receiver writes to rx_ring by DMA, no RXNE interrupts
+	pli_dma_rx_init(&rx_queue, rx_ring, sizeof(rx_ring));
+	uart->CR3 |= USART_CR3_DMAR;
+#endif
+
 	// enable usart
 	MODIFY_REG(USART2->CR1, 0, 1);
 
+#ifdef PL_SERIAL_RX_DMA
+	// enable idle line interrupt
+	uart->CR1 |= UART_CR1_IDLEIE;
+#else
 	// enable rx interrupt
 	uart->CR1 |= UART_CR1_RXNEIE;
+#endif
+
+#ifdef PL_SERIAL_TX_DMA
+	// transmitter is fed by DMA, no TXE interrupts
+	pli_dma_tx_init(&tx_queue);
+	uart->CR3 |= USART_CR3_DMAT;
+#endif
 
 	// init interrupt for USART2
 	tmp = NVIC_GetPriorityGrouping();
@@ -141,7 +220,13 @@ int pli_serial_init(uint32_t baud) {
 void pli_serial_write(uint8_t data) {
 	while (pli_enqueue(&tx_queue, data) == 0) {
 		// wait for free places in transmitter queue
+		tx_waits++;
 	}
+	tx_bytes++;
+
+#ifdef PL_SERIAL_TX_DMA
+	pli_dma_tx_kick();
+#else
 
 	if (!tx_primed) {
 		// activate transmitter interrupt
@@ -154,14 +239,60 @@ void pli_serial_write(uint8_t data) {
 #endif
 
 	}
+#endif
+}
+
+int pli_serial_tx_space(void) {
+	return pli_queue_space(&tx_queue);
+}
+
+int pli_serial_baud_valid(uint32_t baud) {
+	pli_baud setting;
+
+	return pli_baud_compute(kernel_clock(), baud, &setting);
+}
+
+int pli_serial_set_baud(uint32_t baud) {
+	pli_baud setting;
+
+	if (!pli_baud_compute(kernel_clock(), baud, &setting))
+		return -2;	// error: invalid baud rate
+
+	// let everything already written leave at the old rate
+	while (!pli_queue_empty(&tx_queue)) {
+	}
+#ifdef PL_SERIAL_TX_DMA
+	while (pli_dma_tx_busy()) {
+	}
+#endif
+	while (!(uart->ISR & UART_ISR_TC)) {
+	}
+
+	MODIFY_REG(uart->CR1, USART_CR1_UE, 0);
+	baud_set(&setting);
+	MODIFY_REG(uart->CR1, 0, USART_CR1_UE);
+	return 1;
 }
 
 int pli_serial_read(uint8_t *data) {
-	if (pli_dequeue(&rx_queue, data) > 0)
+	if (pli_dequeue(&rx_queue, data) > 0) {
+		rx_bytes++;
 		return 1;
+	}
 	return 0;
 }
 
+int pli_serial_read_bulk(uint8_t *data, int len) {
+	int n = pli_dequeue_bulk(&rx_queue, data, len);
+
+	rx_bytes += n;
+	return n;
+}
+
+int pli_serial_rx_pending(void) {
+	return !pli_queue_empty(&rx_queue);
+}
+
 #ifdef PL_QUEUE_STATISTICS
 void pli_serial_statistics_read(int *read, int *write) {
 	*read = rx_queue.min;
@@ -171,6 +302,18 @@ void pli_serial_statistics_read(int *read, int *write) {
 }
 #endif
 
+void pli_serial_counters_read(pli_serial_counters *counters) {
+	counters->overruns = overruns;
+#ifdef PL_SERIAL_RX_DMA
+	counters->drops = pli_dma_rx_drops();
+#else
+	counters->drops = drops;
+#endif
+	counters->tx_waits = tx_waits;
+	counters->rx_bytes = rx_bytes;
+	counters->tx_bytes = tx_bytes;
+}
+
 uint32_t pli_serial_get_status() {
 	uint32_t status;
 	status = uart->ISR;
@@ -8,10 +8,55 @@
 
 int pli_serial_init(uint32_t baud);
 
+/*
+ * change the baud rate after sending everything queued,
+ * returns -2 if the rate cannot be reached with the kernel clock
+ */
+int pli_serial_set_baud(uint32_t baud);
+
+int pli_serial_baud_valid(uint32_t baud);
+
 void pli_serial_write(uint8_t data);
 
+int pli_serial_tx_space(void);     // bytes pli_serial_write() takes without waiting
+
 int pli_serial_read(uint8_t* data);
 
+/*
+ * read up to len received bytes at once, returns the number read
+ */
+int pli_serial_read_bulk(uint8_t* data, int len);
+
+int pli_serial_rx_pending(void);   // received bytes are waiting
+
+/*
+ * counters since start
+ */
+typedef struct pli_serial_counters {
+    uint32_t overruns;  // bytes not read in time from the receiver (UART overrun)
+    uint32_t drops;     // bytes received, but the rx queue was full
+    uint32_t tx_waits;  // spins of pli_serial_write() waiting for room in the tx queue
+    uint32_t rx_bytes;  // read by plib
+    uint32_t tx_bytes;  // written by plib
+} pli_serial_counters;
+
+void pli_serial_counters_read(pli_serial_counters* counters);
+
+#ifdef PL_HOST
+#include <stddef.h>
+
+/*
+ * host port: write directly to the link to vPeripherals
+ */
+void pli_host_link_write(const uint8_t* data, size_t len);
+
+/*
+ * host port: read what the link has received, at most len bytes,
+ * without waiting; returns the number of bytes read
+ */
+size_t pli_host_link_read(uint8_t* data, size_t len);
+#endif
+
 #ifdef PL_QUEUE_STATISTICS
 void pli_serial_statistics_read(int* read, int* write);
 #endif
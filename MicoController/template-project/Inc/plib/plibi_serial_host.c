@@ -0,0 +1,348 @@
+/*
+ * Serial communication for running a plib application as a Linux
+ * process (PL_HOST). Replaces plibi_serial.c.
+ *
+ * The link to vPeripherals is selected with the environment variable
+ * PLIB_LINK:
+ * - "pty" (default): a pseudo terminal, its name is printed at startup.
+ *   "pty:/path" additionally creates a symlink with that name.
+ *   Connect with: python vp.py -p /dev/pts/N
+ * - "tcp:port": listens on the port, vPeripherals connects with
+ *   python vp.py -p socket://localhost:port
+ *   A new connection is accepted when vPeripherals is restarted.
+ *
+ * Received bytes are fetched with a non-blocking read whenever the
+ * rx queue runs empty, sent bytes are collected in the tx queue and
+ * written at the end of each message ('\n') or when the queue is full.
+ * With PL_SERIAL_TX_DMA the tx queue is sent by the simulated DMA
+ * controller in plibi_dma_host.c instead, with PL_SERIAL_RX_DMA it
+ * also fills the rx queue through a ring as on the board.
+ */
+
+#ifdef PL_HOST
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "plibi_serial.h"
+#include "plibi_baud.h"
+#if defined PL_SERIAL_TX_DMA || defined PL_SERIAL_RX_DMA
+#include "plibi_dma.h"
+#endif
+
+#include "plib_config.h"
+
+#ifndef PL_RX_BUFFER_LEN
+#define PL_RX_BUFFER_LEN 256
+#endif
+#ifndef PL_TX_BUFFER_LEN
+#define PL_TX_BUFFER_LEN 256
+#endif
+
+_Static_assert(PLI_QUEUE_POWER_OF_TWO(PL_RX_BUFFER_LEN), "PL_RX_BUFFER_LEN must be a power of two");
+_Static_assert(PLI_QUEUE_POWER_OF_TWO(PL_TX_BUFFER_LEN), "PL_TX_BUFFER_LEN must be a power of two");
+
+static uint8_t rx_buffer[PL_RX_BUFFER_LEN];
+static uint8_t tx_buffer[PL_TX_BUFFER_LEN];
+
+static pli_queue rx_queue, tx_queue;
+
+static uint32_t tx_waits, rx_bytes, tx_bytes;	// see pli_serial_counters
+
+// pclk1 of the board, so the host accepts the same baud rates
+#define UART_CLOCK 15000000
+
+#ifdef PL_SERIAL_RX_DMA
+#ifndef PL_RX_DMA_LEN
+#define PL_RX_DMA_LEN 64
+#endif
+static uint8_t rx_ring[PL_RX_DMA_LEN];	// written by the DMA thread
+#endif
+
+static int link_fd = -1;	// pty master or tcp connection
+static int listen_fd = -1;	// tcp only
+static pthread_mutex_t link_lock = PTHREAD_MUTEX_INITIALIZER;	// link_fd, also used by the DMA thread
+
+static int open_pty(const char *link) {
+	struct termios tio;
+	int fd, slave;
+	const char *name;
+
+	fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+		return -1;
+	name = ptsname(fd);
+
+	// raw mode, the protocol is binary safe
+	slave = open(name, O_RDWR | O_NOCTTY);
+	if (slave < 0)
+		return -1;
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+	// slave stays open: no EIO on the master while vPeripherals is not connected
+
+	if (link) {
+		unlink(link);
+		if (symlink(name, link) != 0)
+			perror(link);
+	}
+	fprintf(stderr, "plib: vPeripherals link on %s\n", link ? link : name);
+	return fd;
+}
+
+static int open_tcp(int port) {
+	struct sockaddr_in addr = { 0 };
+	int yes = 1;
+
+	listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd < 0)
+		return -1;
+	setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	if (bind(listen_fd, (struct sockaddr*) &addr, sizeof(addr)) != 0
+			|| listen(listen_fd, 1) != 0)
+		return -1;
+	fcntl(listen_fd, F_SETFL, O_NONBLOCK);
+	fprintf(stderr, "plib: vPeripherals link on socket://localhost:%d\n", port);
+	return -1;	// connected later, see poll_accept()
+}
+
+/*
+ * tcp: take the next connection from vPeripherals
+ */
+static void poll_accept(void) {
+	if (listen_fd < 0 || link_fd >= 0)
+		return;
+	pthread_mutex_lock(&link_lock);
+	if (link_fd < 0) {
+		link_fd = accept(listen_fd, NULL, NULL);
+		if (link_fd >= 0)
+			fcntl(link_fd, F_SETFL, O_NONBLOCK);
+	}
+	pthread_mutex_unlock(&link_lock);
+}
+
+// called with link_lock held
+static void link_lost(void) {
+	if (listen_fd >= 0 && link_fd >= 0) {
+		close(link_fd);
+		link_fd = -1;
+		fprintf(stderr, "plib: vPeripherals disconnected\n");
+	}
+}
+
+/*
+ * write to the link; nobody listening on the link
+ * means the data is lost, as on a real UART
+ */
+void pli_host_link_write(const uint8_t *data, size_t len) {
+	size_t done = 0;
+	ssize_t w;
+	int busy;
+
+	poll_accept();
+	while (done < len) {
+		pthread_mutex_lock(&link_lock);
+		if (link_fd < 0) {
+			pthread_mutex_unlock(&link_lock);
+			break;
+		}
+		w = send(link_fd, data + done, len - done, MSG_NOSIGNAL);
+		if (w < 0 && errno == ENOTSOCK)
+			w = write(link_fd, data + done, len - done);
+		busy = w < 0 && errno == EAGAIN;
+		if (w < 0 && !busy)
+			link_lost();
+		pthread_mutex_unlock(&link_lock);
+
+		if (w > 0) {
+			done += w;
+		} else if (busy && listen_fd >= 0) {
+			// tcp: wait for vPeripherals like the UART waits for the shift register
+			usleep(100);
+		} else {
+			break;
+		}
+	}
+}
+
+size_t pli_host_link_read(uint8_t *data, size_t len) {
+	ssize_t n;
+
+	poll_accept();
+	pthread_mutex_lock(&link_lock);
+	n = link_fd < 0 ? 0 : read(link_fd, data, len);
+	if (link_fd >= 0 && (n == 0 || (n < 0 && errno != EAGAIN && errno != EIO)))
+		link_lost();
+	pthread_mutex_unlock(&link_lock);
+	return n > 0 ? (size_t) n : 0;
+}
+
+#ifndef PL_SERIAL_TX_DMA
+static void flush(void) {
+	uint8_t chunk[PL_TX_BUFFER_LEN];
+	size_t n = pli_dequeue_bulk(&tx_queue, chunk, sizeof(chunk));
+
+	pli_host_link_write(chunk, n);
+}
+#endif
+
+int pli_serial_init(uint32_t baud) {
+	static int first_run = 1;
+	const char *link = getenv("PLIB_LINK");
+
+	if (!first_run)
+		return -1; // error: already initialized
+	if (!pli_serial_baud_valid(baud))
+		return -2;	// error: invalid baud rate
+	first_run = 0;
+
+	pli_queue_init(&rx_queue, rx_buffer,
+			sizeof(rx_buffer) / sizeof(rx_buffer[0]));
+	pli_queue_init(&tx_queue, tx_buffer,
+			sizeof(tx_buffer) / sizeof(tx_buffer[0]));
+
+	if (!link || strcmp(link, "pty") == 0) {
+		link_fd = open_pty(NULL);
+	} else if (strncmp(link, "pty:", 4) == 0) {
+		link_fd = open_pty(link + 4);
+	} else if (strncmp(link, "tcp:", 4) == 0) {
+		link_fd = open_tcp(atoi(link + 4));
+		if (listen_fd < 0) {
+			perror("plib: tcp link");
+			return -3;
+		}
+	} else {
+		fprintf(stderr, "plib: unknown PLIB_LINK %s\n", link);
+		return -3;
+	}
+	if (link_fd < 0 && listen_fd < 0) {
+		perror("plib: pty link");
+		return -3;
+	}
+#if defined PL_SERIAL_TX_DMA || defined PL_SERIAL_RX_DMA
+	pli_dma_init();
+#endif
+#ifdef PL_SERIAL_RX_DMA
+	pli_dma_rx_init(&rx_queue, rx_ring, sizeof(rx_ring));
+#endif
+#ifdef PL_SERIAL_TX_DMA
+	pli_dma_tx_init(&tx_queue);
+#endif
+	return 1;
+}
+
+#ifdef PL_SERIAL_TX_DMA
+void pli_serial_write(uint8_t data) {
+	while (pli_enqueue(&tx_queue, data) == 0) {
+		// wait for the DMA thread to free places
+		tx_waits++;
+		sched_yield();
+	}
+	tx_bytes++;
+	pli_dma_tx_kick();
+}
+#else
+void pli_serial_write(uint8_t data) {
+	while (pli_enqueue(&tx_queue, data) == 0) {
+		tx_waits++;
+		flush();
+	}
+	tx_bytes++;
+	if (data == '\n')
+		flush();
+}
+#endif
+
+int pli_serial_tx_space(void) {
+	return pli_queue_space(&tx_queue);
+}
+
+int pli_serial_baud_valid(uint32_t baud) {
+	pli_baud setting;
+
+	return pli_baud_compute(UART_CLOCK, baud, &setting);
+}
+
+int pli_serial_set_baud(uint32_t baud) {
+	if (!pli_serial_baud_valid(baud))
+		return -2;	// error: invalid baud rate
+	// the link has no rate, just send everything queued first
+#ifdef PL_SERIAL_TX_DMA
+	while (!pli_queue_empty(&tx_queue) || pli_dma_tx_busy())
+		sched_yield();
+#else
+	flush();
+#endif
+	return 1;
+}
+
+static void fill(void) {
+#ifndef PL_SERIAL_RX_DMA
+	if (pli_queue_empty(&rx_queue)) {
+		uint8_t chunk[PL_RX_BUFFER_LEN];
+		size_t n = pli_host_link_read(chunk, sizeof(chunk));
+
+		pli_enqueue_bulk(&rx_queue, chunk, n);
+	}
+#endif
+}
+
+int pli_serial_read(uint8_t *data) {
+	fill();
+	if (pli_dequeue(&rx_queue, data) > 0) {
+		rx_bytes++;
+		return 1;
+	}
+	return 0;
+}
+
+int pli_serial_read_bulk(uint8_t *data, int len) {
+	int n;
+
+	fill();
+	n = pli_dequeue_bulk(&rx_queue, data, len);
+	rx_bytes += n;
+	return n;
+}
+
+int pli_serial_rx_pending(void) {
+	fill();
+	return !pli_queue_empty(&rx_queue);
+}
+
+void pli_serial_counters_read(pli_serial_counters *counters) {
+	counters->overruns = 0;	// the link has no receiver that could overflow
+#ifdef PL_SERIAL_RX_DMA
+	counters->drops = pli_dma_rx_drops();
+#else
+	counters->drops = 0;	// read only when the queue is empty
+#endif
+	counters->tx_waits = tx_waits;
+	counters->rx_bytes = rx_bytes;
+	counters->tx_bytes = tx_bytes;
+}
+
+#ifdef PL_QUEUE_STATISTICS
+void pli_serial_statistics_read(int *read, int *write) {
+	*read = rx_queue.min;
+	pli_queue_statistics_reset(&rx_queue);
+	*write = tx_queue.min;
+	pli_queue_statistics_reset(&tx_queue);
+}
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Timers (see plib.h and plibi_timer.h)
+ */
+
+#include "plib.h"
+#include "plib_config.h"
+#include "plibi_timer.h"
+
+static pl_timer *heap[PL_TIMERS];
+static uint8_t heap_len = 0;
+
+// a is due before b, also across the wrap around
+static inline int before(const pl_timer *a, const pl_timer *b) {
+	return (int32_t) (a->due - b->due) < 0;
+}
+
+static inline void place(pl_timer *timer, uint8_t i) {
+	heap[i] = timer;
+	timer->slot = i + 1;
+}
+
+static void sift_up(uint8_t i) {
+	pl_timer *timer = heap[i];
+
+	while (i > 0) {
+		uint8_t parent = (i - 1) / 2;
+
+		if (!before(timer, heap[parent]))
+			break;
+		place(heap[parent], i);
+		i = parent;
+	}
+	place(timer, i);
+}
+
+static void sift_down(uint8_t i) {
+	pl_timer *timer = heap[i];
+
+	for (;;) {
+		uint8_t child = 2 * i + 1;
+
+		if (child >= heap_len)
+			break;
+		if (child + 1 < heap_len && before(heap[child + 1], heap[child]))
+			child++;
+		if (!before(heap[child], timer))
+			break;
+		place(heap[child], i);
+		i = child;
+	}
+	place(timer, i);
+}
+
+static void insert(pl_timer *timer) {
+	heap[heap_len] = timer;
+	sift_up(heap_len++);
+}
+
+static void remove_at(uint8_t i) {
+	heap[i]->slot = 0;
+	if (i == --heap_len)
+		return;
+	// the last one fills the gap and moves to its place
+	heap[i] = heap[heap_len];
+	if (i > 0 && before(heap[i], heap[(i - 1) / 2]))
+		sift_up(i);
+	else
+		sift_down(i);
+}
+
+int pl_timer_started(const pl_timer *timer) {
+	// slot alone may be garbage in a timer that was never started
+	return timer->slot > 0 && timer->slot <= heap_len && heap[timer->slot - 1] == timer;
+}
+
+int pl_timer_start(pl_timer *timer, uint32_t delay, uint32_t period, pl_timer_handler handler) {
+	if (pl_timer_started(timer))
+		remove_at(timer->slot - 1);
+	else if (heap_len >= PL_TIMERS)
+		return -1;
+	timer->handler = handler;
+	timer->due = pl_ticks() + delay;
+	timer->period = period;
+	timer->misses = 0;
+	timer->late_max = 0;
+	insert(timer);
+	return 1;
+}
+
+void pl_timer_stop(pl_timer *timer) {
+	if (pl_timer_started(timer))
+		remove_at(timer->slot - 1);
+}
+
+int pli_timer_due(uint32_t now) {
+	return heap_len && (int32_t) (now - heap[0]->due) >= 0;
+}
+
+int pli_timer_run(uint32_t now) {
+	int ran = 0;
+
+	// at most as many runs as timers are started, a handler starting a
+	// timer due at once cannot keep pl_do() here
+	for (int n = heap_len; n > 0 && pli_timer_due(now); n--) {
+		pl_timer *timer = heap[0];
+		uint32_t late = now - timer->due;
+
+		if (late > timer->late_max)
+			timer->late_max = late;
+		if (timer->period) {
+			uint32_t skipped = late / timer->period;
+
+			// the next run on the grid after now, before the handler may stop it
+			timer->misses += skipped;
+			timer->due += (skipped + 1) * timer->period;
+			sift_down(0);
+		} else
+			remove_at(0);
+		if (timer->handler)
+			timer->handler(timer);
+		ran++;
+	}
+	return ran;
+}
@@ -0,0 +1,24 @@
+#ifndef PLIBI_TIMER_H_
+#define PLIBI_TIMER_H_
+
+#include <stdint.h>
+
+/*
+ * Timers of plib (pl_timer_start() in plib.h), kept in a binary min-heap
+ * ordered by due time: the earliest timer is at the top, starting,
+ * stopping and running one costs O(log PL_TIMERS), checking for due work
+ * O(1). Times compare by their difference, so they may wrap around.
+ * Only used from the super loop, nothing is shared with interrupts.
+ */
+
+/*
+ * calls the handlers of all timers due at now, returns their number
+ */
+int pli_timer_run(uint32_t now);
+
+/*
+ * returns 1 if a timer is due at now
+ */
+int pli_timer_due(uint32_t now);
+
+#endif
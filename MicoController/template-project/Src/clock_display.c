@@ -0,0 +1,52 @@
+/*
+ * clock_display.c
+ *
+ * Bit patterns for the seven segment display of the alarm clock.
+ */
+
+#include "clock_display.h"
+
+// Combined Bits for the different digits
+#define DIGIT_0 0x3F
+#define DIGIT_1 0x06
+#define DIGIT_2 0x5B
+#define DIGIT_3 0x4F
+#define DIGIT_4 0x66
+#define DIGIT_5 0x6D
+#define DIGIT_6 0x7D
+#define DIGIT_7 0x07
+#define DIGIT_8 0x7F
+#define DIGIT_9 0x6F
+
+uint32_t calc_display(uint8_t hour, uint8_t minute, bool blink, bool alarm_on, bool beep_on) {
+	
+	const uint8_t digits[] = {DIGIT_0, DIGIT_1, DIGIT_2, DIGIT_3, DIGIT_4, DIGIT_5, DIGIT_6, DIGIT_7, DIGIT_8, DIGIT_9};
+
+	uint8_t minutes_one = 0;
+	uint8_t minutes_ten = 0;
+	uint8_t hours_one = 0;
+	uint8_t hours_ten = 0;
+
+	minutes_one = digits[minute % 10];
+	minutes_ten = digits[minute / 10];
+	hours_one = digits[hour % 10];
+	hours_ten = digits[hour / 10];
+
+	// blinking points
+	
+	if (blink) {
+		minutes_ten |= (1 << 7);
+	}
+	if (beep_on) {
+		minutes_one |= (1 << 7);
+	}
+	if (alarm_on) {
+		hours_one |= (1 << 7);
+	}
+		
+
+	// 32 Bit = 4 Byte --> hours_ten shifted to Byte 3, hours_one shifted to Byte 2, ....
+	uint32_t displayTime = (hours_ten << 24) | (hours_one << 16) | (minutes_ten << 8) | minutes_one;
+
+	return displayTime;
+}
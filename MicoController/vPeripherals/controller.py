@@ -6,6 +6,9 @@ import sv_ttk
 from model import Model
 import serial
 import datetime
+import frames
+import telemetry
+import linkstats
 from view import View
 from myutils import struct, dotdict
 
@@ -24,18 +27,47 @@ class Controller:
                 'L': self.incoming_log_setter,
                 'S': self.incoming_screen_setter,
                 'D': self.incoming_debug_setter,
+                'B': self.incoming_baud_setter,
+                'y': self.incoming_telemetry_channel_setter,
+                'Y': self.incoming_telemetry_block_setter,
+                'Q': self.incoming_link_setter,
+                'q': self.incoming_protocol_setter,
+                'C': self.incoming_credit_setter,
                 }
         self.requesters={
                 'T': self.incoming_time_requester,
                 'V': self.incoming_version_requester,
                 }
         if self.config.serial_port != None:
-            self.serial_interface = serial.Serial(
+            # serial_for_url also accepts socket://host:port (plib host port)
+            self.serial_interface = serial.serial_for_url(
                     self.config.serial_port, 
                     self.config.serial_baud, 
                     timeout=0, 
-                    writeTimeout=0) #ensure non-blocking
-            self.serial_read_buffer = ''
+                    write_timeout=0) #ensure non-blocking
+            self.serial_receiver = frames.Receiver()
+        # plib reads frames (plibi_frame.h), it told us with '?Vb'
+        self.frames = False
+        # baud rate switch proposed to plib ('dB'), outgoing messages wait for the answer
+        self.baud_pending = None
+        self.baud_wait = 0
+        self.baud_held = []
+        # telemetry of plib, plotted in a window of its own once channels are declared
+        self.telemetry = telemetry.Telemetry()
+        self.plot = None
+        self.plot_wait = 0
+        self.telemetry_asked = 0    # iterations until we ask for the channels again
+        # link statistics of plib, asked every second with -s
+        self.link = None
+        self.link_wait = 0
+        # bytes a non-blocking write did not take yet, or plib has no credits for
+        self.tx_held = bytearray()
+        self.tx_free = 0    # held bytes of before the credits, e.g. the rest of 'dV'
+        self.tx_polling = False
+        # credits of plib ('dC'): total bytes we may have sent since our 'dV', mod 0x10000
+        self.credits = False
+        self.credit_limit = 0
+        self.credit_sent = 0
             
         
     def run(self):
@@ -88,9 +120,34 @@ class Controller:
     def do(self):
         if self.config.serial_port != None: 
             self.serial_read()
+            self.tx_write()
         if self.first:
             self.first = False
+            link_baud = self.config.link_baud
+            if self.config.serial_port != None and link_baud and link_baud != self.config.serial_baud:
+                self.outgoing(f'dB{link_baud}')
+                self.baud_pending = link_baud
+                self.baud_wait = 100    # iterations of 10 ms
             self.outgoing('?S')    # query MCU for current screen     
+        if self.telemetry_asked:
+            self.telemetry_asked -= 1
+        if self.config.statistics and self.config.serial_port != None:
+            if self.link is None:
+                self.link = linkstats.LinkStatistics(self.root)
+            self.link_wait -= 1
+            if self.link.open and self.link_wait <= 0:
+                self.outgoing('?Q')
+                self.outgoing('?q')
+                self.link_wait = 100    # iterations of 10 ms
+        self.plot_wait -= 1
+        if self.plot and self.plot.open and self.plot_wait <= 0:
+            self.plot.redraw()
+            self.plot_wait = 10     # iterations of 10 ms
+        if self.baud_pending:
+            self.baud_wait -= 1
+            if self.baud_wait <= 0:
+                self.debug_message(f'no answer to baud rate {self.baud_pending}, staying at {self.config.serial_baud}')
+                self.baud_done()
         if self.config.test >= 0 or self.config.messages:
             t=self._test
             t.call_counter += 1
@@ -111,6 +168,63 @@ class Controller:
     def incoming_debug_setter(self, message, position):
          self.view.handle_debug(message[position:])
          
+    def incoming_baud_setter(self, message, position):
+        # plib accepted the rate and has switched after sending this
+        baud = int(message[position:])
+        if baud != self.baud_pending:
+            self.debug_message(f'unexpected baud rate acknowledge: {message}')
+            return
+        self.serial_interface.baudrate = baud
+        self.config.serial_baud = baud
+        self.root.title('vPeripherals {}@{}'.format(self.config.serial_port, str(baud)))
+        if self.config.verbose >= 1:
+            print(f'link switched to {baud} baud')
+        self.baud_done()
+
+    def incoming_telemetry_channel_setter(self, message, position):
+        if not self.telemetry.declare(message, position):
+            self.debug_message(f'invalid telemetry channel: {message}')
+            return
+        if self.plot is None or not self.plot.open:
+            self.plot = telemetry.Plot(self.root, self.telemetry)
+
+    def incoming_telemetry_block_setter(self, message, position):
+        if not self.telemetry.block(message, position) and not self.telemetry_asked:
+            # started after plib declared its channels
+            self.outgoing('?y')
+            self.telemetry_asked = 100    # iterations of 10 ms
+
+    def incoming_link_setter(self, message, position):
+        if self.link and not self.link.show(linkstats.LINK, message[position:]):
+            self.debug_message(f'invalid link statistics: {message}')
+
+    def incoming_protocol_setter(self, message, position):
+        if self.link and not self.link.show(linkstats.PROTOCOL, message[position:]):
+            self.debug_message(f'invalid protocol statistics: {message}')
+
+    def incoming_credit_setter(self, message, position):
+        try:
+            self.credit_limit = int(message[position:position + 4], 16)
+        except ValueError:
+            self.debug_message(f'invalid credit: {message}')
+            return
+        self.tx_write()
+
+    def credits_start(self):
+        # plib counts the bytes after our 'dV' and grants the first ones with 'dC'
+        self.credits = True
+        self.credit_limit = 0
+        self.credit_sent = 0
+        self.tx_free = len(self.tx_held)
+        if self.config.verbose >= 1:
+            print('credits negotiated')
+
+    def baud_done(self):
+        self.baud_pending = None
+        held, self.baud_held = self.baud_held, []
+        for message, written in held:
+            self.outgoing(message, written)
+
     def incoming_screen_setter(self, message, position):
         if self.config.verbose >= 2:
             print(f'set screen {message[position:]}')         
@@ -158,7 +272,7 @@ class Controller:
                 self.debug_message(f'request to non-active screen {id}: {message}')
         else:                                               # default: report to debug widget
             answer = f'e01{message}'
-            self.debug_message('unknown item in requester:' + self.serial_read_buffer)
+            self.debug_message('unknown item in requester:' + message)
         if answer is not None:
             self.outgoing(answer)
 
@@ -170,34 +284,42 @@ class Controller:
     
     def incoming_version_requester(self, message, position):
         d = 'd' if self.config.debug else ''
-        answer = f'dV03{d}'   # todo: version is currently hard coded
+        b = 'b' if 'b' in message[position:] else ''    # we read frames too
+        c = 'c' if 'c' in message[position:] else ''    # we wait for credits
+        answer = f'dV03{d}{b}{c}'   # todo: version is currently hard coded
         for id in self.screens.keys():
             answer += chr(id + ord('0'))
-        return answer
+        # plib has (re)started with an empty rx buffer and without credits,
+        # what we still hold was meant for before
+        if self.tx_held:
+            self.debug_message(f'plib restarted, {len(self.tx_held)} bytes not sent')
+        self.tx_held.clear()
+        self.credits = False
+        self.outgoing(answer, self.credits_start if c else None)
+        if b:
+            # plib sends frames once it has this answer, we do from now on
+            self.frames = True
+            if self.config.verbose >= 1:
+                print('binary frames negotiated')
+        return None
         
     def serial_read(self):
         while True:
             try:
-                c = self.serial_interface.read().decode('utf-8', errors='ignore') 
+                data = self.serial_interface.read(256)
             except Exception as err:
                 print(f'Read from MCU failed: {err}\n-> exiting.')
                 sys.exit(1)
-                c = ''
-            if len(c) == 0:
+            if len(data) == 0:
                 break
             if self.config.verbose >= 5:
-                print('add >{}< to {}'.format(c, self.serial_read_buffer))
-
-            # check if character is a delimiter
-            if c not in '\n\r':
-                self.serial_read_buffer+=c
-            else:
-                #add the line to the log
+                print('add >{}<'.format(data))
+            # text lines as well as frames
+            for message in self.serial_receiver.put(data):
                 if self.config.verbose >= 2:
-                    print(f'> {self.serial_read_buffer}') #[:-1]}')
-                if len(self.serial_read_buffer) >= 2:    
-                    self.incoming(self.serial_read_buffer)
-                self.serial_read_buffer = ''
+                    print(f'> {message}')
+                if len(message) >= 2:    
+                    self.incoming(message)
 
     def incoming(self, message):
         c = message[0]
@@ -208,6 +330,8 @@ class Controller:
             self.incoming_requester(message, 1)
         elif c == 'e': # error
             self.debug_message('incoming error message:' + message)
+            if self.baud_pending and message[3:5] == 'dB':
+                self.baud_done()    # plib cannot reach the rate, stay
         else:   
             pass # ignore erroneous messages
  
@@ -231,14 +355,59 @@ class Controller:
             print(f'loaded screens: {screens}')
         return screens
 
-    def outgoing(self, message):
+    def outgoing(self, message, written=None):
+        '''sends message, then calls written'''
+        if self.baud_pending:
+            # plib may already be at the new rate
+            self.baud_held.append((message, written))
+            return
         if self.config.verbose >= 2:
             print(f'<\t{message}')
         if self.config.serial_port != None:
-            try:
-                self.serial_interface.write(message.encode('utf-8'))
-                self.serial_interface.write(b'\n')
-            except Exception as err:
-                print(f'Write to MCU failed: {err}\n-> exiting.')
-                sys.exit(1)
+            if self.frames:
+                data = frames.encode(message)
+            else:
+                data = message.encode('utf-8') + b'\n'
+            self.tx_held += data
+            self.tx_write()
+        if written:
+            written()
+
+    def tx_write(self):
+        '''writes held bytes, with credits as far as plib has granted'''
+        if not self.tx_held:
+            return
+        if self.credits:
+            granted = (self.credit_limit - self.credit_sent) & 0xffff
+            if granted > 0x8000:
+                granted = 0     # a credit older than the bytes sent
+            granted += self.tx_free
+        else:
+            granted = len(self.tx_held)
+        n = self.serial_write(self.tx_held[:granted])
+        del self.tx_held[:n]
+        if self.credits:
+            free = min(n, self.tx_free)
+            self.tx_free -= free
+            self.credit_sent = (self.credit_sent + n - free) & 0xffff
+        if self.tx_held and not self.tx_polling:
+            # do not wait for the next do(): read credits as soon as they come
+            self.tx_polling = True
+            self.root.after(1, self.tx_poll)
+
+    def tx_poll(self):
+        self.tx_polling = False
+        self.serial_read()
+        self.tx_write()
+
+    def serial_write(self, data):
+        '''writes data without waiting, returns the number of bytes written'''
+        if not data:
+            return 0
+        try:
+            n = self.serial_interface.write(data)
+        except Exception as err:
+            print(f'Write to MCU failed: {err}\n-> exiting.')
+            sys.exit(1)
+        return len(data) if n is None else n
   
\ No newline at end of file
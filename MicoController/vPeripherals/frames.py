@@ -0,0 +1,120 @@
+# Binary framing of the plib messages, see plibi_frame.h in plib.
+# A frame carries one text message: SLIP framed, protected by a
+# CRC-16/CCITT, hex fields of the messages in PACKED sent as bytes.
+
+END = 0xc0
+ESC = 0xdb
+ESC_END = 0xdc
+ESC_ESC = 0xdd
+TEXT = 0x80
+TYPE_LAST = 0xbf
+
+# type 0x81 + index: prefix, number of bytes following as hex (0: all); same table as in plibi_frame.c
+PACKED = [
+    ('d1', 4),      # alarm clock display
+    ('d2', 6),      # seesaw, followed by 't' or 'f'
+    ('d00', 1),     # led
+    ('d01', 1),     # switch
+    ('d02', 1),     # button
+    ('d0a', 2),     # adc
+    ('d0b', 2),
+    ('d0c', 2),
+    ('dY', 0),      # telemetry block: all digits of the message
+]
+
+_HEX = set('0123456789abcdef')
+
+def crc16(data, crc=0xffff):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xffff
+    return crc
+
+def pack(message):
+    '''payload of a frame for a text message (without '\\n')'''
+    for i, (prefix, count) in enumerate(PACKED):
+        if count == 0:
+            digits = message[len(prefix):]
+            if message.startswith(prefix) and digits and len(digits) % 2 == 0 and set(digits) <= _HEX:
+                return bytes([TEXT + 1 + i]) + bytes.fromhex(digits)
+            continue
+        digits = message[len(prefix):len(prefix) + 2 * count]
+        if message.startswith(prefix) and len(digits) == 2 * count and set(digits) <= _HEX:
+            rest = message[len(prefix) + 2 * count:]
+            return bytes([TEXT + 1 + i]) + bytes.fromhex(digits) + rest.encode('utf-8')
+    return bytes([TEXT]) + message.encode('utf-8')
+
+def unpack(payload):
+    '''text message of a payload, None if the type is unknown'''
+    kind = payload[0]
+    data = payload[1:]
+    if kind == TEXT:
+        return data.decode('utf-8', errors='ignore')
+    i = kind - TEXT - 1
+    if i >= len(PACKED) or len(data) < PACKED[i][1]:
+        return None
+    prefix, count = PACKED[i]
+    if count == 0:
+        return prefix + data.hex()
+    return prefix + data[:count].hex() + data[count:].decode('utf-8', errors='ignore')
+
+def encode(message):
+    '''complete frame for a text message'''
+    payload = pack(message)
+    crc = crc16(payload)
+    frame = bytearray()
+    for b in payload + bytes([crc >> 8, crc & 0xff]):
+        if b == END:
+            frame += bytes([ESC, ESC_END])
+        elif b == ESC:
+            frame += bytes([ESC, ESC_ESC])
+        else:
+            frame.append(b)
+    frame.append(END)
+    return bytes(frame)
+
+class Receiver:
+    '''splits the bytes from the link into messages, text lines as well as frames'''
+    def __init__(self):
+        self.buffer = bytearray()
+        self.frame = False
+        self.escape = False
+        self.errors = 0     # frames dropped: wrong crc, unknown type
+
+    def put(self, data):
+        '''returns the list of messages completed by data'''
+        messages = []
+        for b in data:
+            if not self.buffer and not self.frame and TEXT <= b <= TYPE_LAST:
+                self.frame = True
+            if self.frame:
+                if b == END:
+                    message = None
+                    if len(self.buffer) >= 3 and crc16(self.buffer) == 0:
+                        message = unpack(bytes(self.buffer[:-2]))
+                    if message is None:
+                        self.errors += 1
+                    else:
+                        messages.append(message)
+                    self._restart()
+                elif b == ESC:
+                    self.escape = True
+                else:
+                    if self.escape:
+                        b = END if b == ESC_END else ESC
+                        self.escape = False
+                    self.buffer.append(b)
+            elif b in b'\n\r':
+                if self.buffer:
+                    messages.append(self.buffer.decode('utf-8', errors='ignore'))
+                self._restart()
+            else:
+                self.buffer.append(b)
+        return messages
+
+    def _restart(self):
+        self.buffer = bytearray()
+        self.frame = False
+        self.escape = False
@@ -0,0 +1,60 @@
+import tkinter as tk
+from myutils import HeaderFrame
+
+# Link statistics of plib (pl_link_statistics_get() in plib.h), asked with '?Q' and '?q':
+# 'dQ' rx/tx rate (4 hex digits each), rx/tx bytes, overruns, drops, tx waits (8 each),
+#      rx/tx lowest free buffer bytes (4 each), printf characters dropped (8)
+# 'dq' messages, parse mean, parse max, frame errors, errors e01..e06 (8 hex digits each)
+
+LINK = [('rx rate', 4, 'bytes/s'), ('tx rate', 4, 'bytes/s'), ('rx bytes', 8, ''), ('tx bytes', 8, ''),
+        ('overruns', 8, ''), ('rx drops', 8, ''), ('tx waits', 8, ''),
+        ('rx min free', 4, 'bytes'), ('tx min free', 4, 'bytes'), ('printf drops', 8, 'characters')]
+PROTOCOL = [('messages', 8, ''), ('parse mean', 8, 'cycles (ns on host)'),
+        ('parse max', 8, 'cycles (ns on host)'),
+        ('frame errors', 8, '')] + [(f'errors e0{i}', 8, '') for i in range(1, 7)]
+
+def decode(fields, data):
+    '''values of fields in data, None if it does not fit'''
+    values = []
+    try:
+        for name, digits, unit in fields:
+            if len(data) < digits:
+                return None
+            values.append(int(data[:digits], 16))
+            data = data[digits:]
+    except ValueError:
+        return None
+    return values if not data else None
+
+class LinkStatistics:
+    '''window with the latest statistics, the lowest free bytes as seen since opening'''
+    def __init__(self, root):
+        self.window = tk.Toplevel(root)
+        self.window.title('Link')
+        frame = HeaderFrame(self.window, 'Link statistics')
+        frame.grid(row=0, column=0, padx=10, pady=10)
+        self.labels = {}
+        for row, (name, digits, unit) in enumerate(LINK + PROTOCOL):
+            tk.ttk.Label(frame, text=name).grid(row=row, column=0, sticky='w', padx=(0, 10))
+            label = tk.ttk.Label(frame, text='-')
+            label.grid(row=row, column=1, sticky='e')
+            tk.ttk.Label(frame, text=unit).grid(row=row, column=2, sticky='w', padx=(5, 0))
+            self.labels[name] = label
+        self.lowest = {}
+        self.window.protocol('WM_DELETE_WINDOW', self.close)
+        self.open = True
+
+    def close(self):
+        self.open = False
+        self.window.destroy()
+
+    def show(self, fields, data):
+        values = decode(fields, data)
+        if values is None or not self.open:
+            return values is not None
+        for (name, digits, unit), value in zip(fields, values):
+            if name.endswith('min free'):
+                # plib restarts the minimum with every request
+                value = self.lowest[name] = min(value, self.lowest.get(name, value))
+            self.labels[name].configure(text=str(value))
+        return True
@@ -0,0 +1,110 @@
+import struct as binary
+from collections import deque
+import tkinter as tk
+from myutils import HeaderFrame
+
+# Telemetry of plib (pl_telemetry_channel() in plib.h):
+# 'dy' channel type name declares a channel, type as in Python's struct,
+# 'dY' blocks carry hex: sequence (1 byte), dropped (2 bytes), then samples of
+# time (2 bytes, ticks) and the values of all channels, big endian.
+
+COLORS = ['#e41a1c', '#377eb8', '#4daf4a', '#ff7f00']
+
+class Telemetry:
+    def __init__(self, length=2000):
+        self.channels = {}      # channel: (type, name)
+        self.layout = None      # struct format of a sample
+        self.samples = deque(maxlen=length)    # (time, values)
+        self.time = None        # unwrapped time of the last sample
+        self.sequence = None
+        self.dropped = 0        # samples plib could not buffer
+        self.lost = 0           # blocks missing in the sequence
+
+    def declare(self, message, position):
+        channel = ord(message[position]) - ord('0')
+        kind = message[position + 1]
+        if kind not in 'bhHf' or channel > len(self.channels):
+            return False
+        # redeclaring removes the channels after it, as plib does
+        self.channels = {c: v for c, v in self.channels.items() if c < channel}
+        self.channels[channel] = (kind, message[position + 2:])
+        self.layout = '>H' + ''.join(self.channels[c][0] for c in sorted(self.channels))
+        self.samples.clear()
+        self.time = None
+        self.sequence = None
+        return True
+
+    def block(self, message, position):
+        '''returns False if the block does not fit to the declared channels'''
+        if self.layout is None:
+            return False
+        try:
+            data = bytes.fromhex(message[position:])
+        except ValueError:
+            return False
+        size = binary.calcsize(self.layout)
+        if len(data) < 3 or (len(data) - 3) % size:
+            return False
+        sequence = data[0]
+        if self.sequence is not None:
+            self.lost += (sequence - self.sequence - 1) & 0xff
+        self.sequence = sequence
+        self.dropped += data[1] << 8 | data[2]
+        for sample in binary.iter_unpack(self.layout, data[3:]):
+            self.samples.append((self.unwrap(sample[0]), sample[1:]))
+        return True
+
+    def unwrap(self, ticks):
+        # plib sends the lower 16 bits of its tick counter
+        if self.time is None:
+            self.time = ticks
+        else:
+            self.time += (ticks - self.time) & 0xffff
+        return self.time
+
+class Plot:
+    '''window with a line per channel, the latest samples'''
+    def __init__(self, root, telemetry, width=600, height=300):
+        self.telemetry = telemetry
+        self.width = width
+        self.height = height
+        self.window = tk.Toplevel(root)
+        self.window.title('Telemetry')
+        frame = HeaderFrame(self.window, 'Telemetry')
+        frame.grid(row=0, column=0, padx=10, pady=10)
+        self.canvas = tk.Canvas(frame, width=width, height=height, bg='black', highlightthickness=0)
+        self.canvas.grid(row=1, column=0)
+        self.status = tk.ttk.Label(frame, text='')
+        self.status.grid(row=2, column=0, sticky='w')
+        self.window.protocol('WM_DELETE_WINDOW', self.close)
+        self.open = True
+
+    def close(self):
+        self.open = False
+        self.window.destroy()
+
+    def redraw(self):
+        if not self.open:
+            return
+        t = self.telemetry
+        c = self.canvas
+        c.delete('all')
+        samples = list(t.samples)
+        names = [t.channels[k][1] for k in sorted(t.channels)]
+        for i, name in enumerate(names):
+            c.create_text(10, 12 + 14 * i, text=name, anchor='w', fill=COLORS[i % len(COLORS)])
+        self.status.configure(text=f'{len(samples)} samples, {t.dropped} dropped by plib, {t.lost} blocks lost')
+        if len(samples) < 2:
+            return
+        t0, t1 = samples[0][0], samples[-1][0]
+        span = max(t1 - t0, 1)
+        for i in range(len(names)):
+            values = [s[1][i] for s in samples]
+            low, high = min(values), max(values)
+            if high == low:
+                high, low = high + 1, low - 1
+            points = []
+            for (time, v), value in zip(samples, values):
+                points.append((time - t0) * (self.width - 1) / span)
+                points.append((high - value) * (self.height - 1) / (high - low))
+            c.create_line(*points, fill=COLORS[i % len(COLORS)])
@@ -13,12 +13,17 @@ def parse_args():
     parser.add_argument('-l', '--list', action='store_true', help='show list \
     of serial interfaces and exit')
     parser.add_argument('-p', '--port', help='use this serial port - can be omitted,\
-    if only one port exists')
+    if only one port exists. socket://host:port connects to a plib host build')
     parser.add_argument('-b', '--baud', default='9600', type=int, 
-    choices=[9600, 19200, 38400, 115200], help='defaults to 9600')
+    choices=[9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600], help='defaults to 9600')
+    parser.add_argument('-B', '--link-baud', type=int, 
+    choices=[19200, 38400, 57600, 115200, 230400, 460800, 921600], help='after connecting, \
+    ask plib to switch both ends to this rate')
     parser.add_argument('-v', '--verbose', action='count', default=0, help='\
     repeat to be more verbose')
     parser.add_argument('-d', '--debug', action='store_true', help='show debug window')
+    parser.add_argument('-s', '--statistics', action='store_true', help='show the link statistics \
+    of plib, updated every second')
     parser.add_argument('-t', '--test', default='-1', type=int, 
             choices=[0,1,2,3,4,5,6,7,8,9], help='test a specific screen (development only)')
     parser.add_argument('-m', '--messages', default=0, type=int, 
@@ -52,8 +57,10 @@ if __name__ == '__main__':
     config = struct()
     config.serial_port = args.port
     config.serial_baud = args.baud
+    config.link_baud = args.link_baud
     config.verbose = args.verbose
     config.debug = args.debug
+    config.statistics = args.statistics
     config.test = args.test
     config.appearance_mode = args.mode
     if args.messages < 0:
@@ -9,7 +9,9 @@ WordCheck.c	a simple console game
 #include<stdio.h>
 #include<unistd.h>
 
-#define WORDLEN 		80
+#include "dictionary.h"
+
+#define WORDLEN 		DICTIONARY_WORDLEN
 #define MAXOUTPUT_LEN 	(WORDLEN + 20)
 #define INCOMPLETE 		1
 #define WON 			2
@@ -25,44 +27,8 @@ void ServerProcess (
   )
 {
 	int	  max_lives=10;	/* number of guesses we offer */
-	char  *words []= { 		/* the words to be guessed */
-		"applicationlayer",
-		"presentationlayer",
-		"sessionlayer",
-		"transportlayer",
-		"datalinklayer",
-		"networklayer",
-		"physicallayer",
-		"transmissioncontrolprotocol",
-		"userdatagramprotocol",
-
-		"arpa",
-		"internet",
-		"rfc",
-		"addressresolutionprotocol"
-		"reverseaddressresolutionprotocol",
-		"fragmentation",
-		"networkaccesslayer",
-		"internetcontrolmessageprotocol",
-		"filetransferprotocol",
-		"hypertexttransferprotocol",
-		"simplemailtransferprotocol",
-		"networknewsprotocol",
-
-
-		"asterix",
-		"obelix",
-		"miraculix",
-		"idefix",
-		"majestix",
-		"gutemine",
-		"methusalix",
-		"verleihnix",
-		"troubardix"
-        };
-
+ 	const char *whole_word;	/* points into builtin_words */
  	char  part_word [WORDLEN],
- 		  *whole_word,
  		  guess_word[WORDLEN],
  		  hostname[WORDLEN],
  		  outbuff[MAXOUTPUT_LEN];
@@ -73,6 +39,7 @@ void ServerProcess (
      	 i;
  	time_t  timer;
     struct tm *t;
+    int   pick;
 
 	/*
 	 * initialize
@@ -85,11 +52,9 @@ void ServerProcess (
  	time (&timer);
  	t = (struct tm *) malloc (sizeof (struct tm));
  	t = localtime (&timer);
- 	whole_word = words [
-	  (t->tm_sec + rand()) %
-	  (sizeof (words) / sizeof (char*))
-	  ];
- 	word_len = strlen (whole_word);
+ 	pick = (t->tm_sec + rand()) % builtin_words.count;
+ 	whole_word = builtin_words.text + builtin_words.offset [pick];
+ 	word_len = builtin_words.length [pick];
  	syslog (LOG_USER|LOG_INFO,
   		"wordd server chose word %s ",whole_word);
 
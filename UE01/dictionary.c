@@ -0,0 +1,249 @@
+/*
+ * dictionary.c -- word lists for the hangman service,
+ * replaceable at runtime
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dictionary.h"
+
+static dictionary *_Atomic pending = NULL;	/* published, not yet picked up */
+static dictionary *current = NULL;			/* used for new games */
+
+/*
+ * a dictionary under construction, the word table only
+ * provides read access
+ */
+typedef struct builder
+{
+	dictionary *d;
+	char *text;
+	uint32_t *offset;
+	uint8_t *length;
+	uint32_t *mask;
+	size_t pos;		/* end of text so far */
+} builder;
+
+/*
+ * allocate an empty dictionary for count words with text_len
+ * characters (including the '\0's)
+ */
+static int builder_init(builder *b, int count, size_t text_len)
+{
+	memset(b, 0, sizeof(*b));
+	b->d = (dictionary *)calloc(1, sizeof(dictionary));
+	b->text = (char *)malloc(text_len);
+	b->offset = (uint32_t *)malloc(count * sizeof(uint32_t));
+	b->length = (uint8_t *)malloc(count);
+	b->mask = (uint32_t *)malloc(count * sizeof(uint32_t));
+	if (!b->d || !b->text || !b->offset || !b->length || !b->mask)
+	{
+		free(b->d);
+		free(b->text);
+		free(b->offset);
+		free(b->length);
+		free(b->mask);
+		return 0;
+	}
+	b->d->words.text = b->text;
+	b->d->words.offset = b->offset;
+	b->d->words.length = b->length;
+	b->d->words.mask = b->mask;
+	return 1;
+}
+
+/*
+ * append word (len characters)
+ */
+static void builder_add(builder *b, const char *word, size_t len)
+{
+	int i = b->d->words.count++;
+	size_t j;
+
+	memcpy(b->text + b->pos, word, len);
+	b->text[b->pos + len] = '\0';
+	b->offset[i] = b->pos;
+	b->length[i] = len;
+	b->mask[i] = 0;
+	for (j = 0; j < len; j++)
+		b->mask[i] |= dictionary_letter(word[j]);
+	b->pos += len + 1;
+}
+
+static int valid_word(const char *word, size_t len)
+{
+	size_t i;
+
+	if (len == 0 || len > DICTIONARY_MAXLETTERS)
+		return 0;
+	for (i = 0; i < len; i++)
+		if (word[i] < 'a' || word[i] > 'z')
+			return 0;
+	return 1;
+}
+
+/*
+ * build a dictionary from a word list, one word per line, empty
+ * lines and lines starting with '#' are ignored. Words must consist
+ * of lower case letters only, at most DICTIONARY_MAXLETTERS. The
+ * whole list is rejected if a line is invalid. content[size] must
+ * be '\n', name is used for messages.
+ */
+static dictionary *parse_words(const char *content, size_t size, const char *name)
+{
+	const char *line, *end;
+	int count = 0, lineno = 0, pass;
+	builder b;
+
+	/*
+	 * pass 0 validates and counts, pass 1 copies
+	 */
+	for (pass = 0; pass < 2; pass++)
+	{
+		lineno = 0;
+		for (line = content; line < content + size; line = end + 1)
+		{
+			size_t len;
+
+			end = memchr(line, '\n', content + size + 1 - line);
+			len = end - line;
+			lineno++;
+			if (len && line[len - 1] == '\r')
+				len--;
+			if (len == 0 || line[0] == '#')
+				continue;
+			if (pass == 0)
+			{
+				if (!valid_word(line, len))
+				{
+					fprintf(stderr, "%s:%d: invalid word\n", name, lineno);
+					return NULL;
+				}
+				count++;
+			}
+			else
+				builder_add(&b, line, len);
+		}
+		if (pass == 0)
+		{
+			if (count == 0)
+			{
+				fprintf(stderr, "%s: no words\n", name);
+				return NULL;
+			}
+			if (!builder_init(&b, count, size + 1))
+				return NULL;
+		}
+	}
+	return b.d;
+}
+
+/*
+ * load a word list from a file, see parse_words()
+ */
+dictionary *dictionary_load(const char *path)
+{
+	FILE *f;
+	char *content;
+	long size;
+	dictionary *d;
+
+	f = fopen(path, "rb");
+	if (!f)
+	{
+		perror(path);
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0)
+	{
+		fclose(f);
+		return NULL;
+	}
+	rewind(f);
+	content = (char *)malloc(size + 1);
+	if (!content || fread(content, 1, size, f) != (size_t)size)
+	{
+		fclose(f);
+		free(content);
+		return NULL;
+	}
+	fclose(f);
+	content[size] = '\n';
+
+	d = parse_words(content, size, path);
+	free(content);
+	return d;
+}
+
+/*
+ * word list of len bytes in memory, e.g. from a trace
+ */
+dictionary *dictionary_parse(const char *text, size_t len, const char *name)
+{
+	char *content = (char *)malloc(len + 1);
+	dictionary *d;
+
+	if (!content)
+		return NULL;
+	memcpy(content, text, len);
+	content[len] = '\n';
+	d = parse_words(content, len, name);
+	free(content);
+	return d;
+}
+
+void dictionary_free(dictionary *d)
+{
+	if (!d || d->builtin)
+		return;
+	free((void *)d->words.text);
+	free((void *)d->words.offset);
+	free((void *)d->words.length);
+	free((void *)d->words.mask);
+	free(d);
+}
+
+/*
+ * hand over d to the event loop, it will be used for new games
+ */
+void dictionary_publish(dictionary *d)
+{
+	dictionary *old = atomic_exchange_explicit(&pending, d, memory_order_acq_rel);
+
+	/* a dictionary published before, but never picked up, has no readers */
+	dictionary_free(old);
+}
+
+dictionary *dictionary_acquire(void)
+{
+	if (atomic_load_explicit(&pending, memory_order_relaxed))
+	{
+		dictionary *next = atomic_exchange_explicit(&pending, NULL, memory_order_acquire);
+
+		if (next)
+		{
+			if (current)
+				dictionary_release(current);	/* drop the reference of "current" */
+			current = next;
+			current->refs = 1;
+		}
+	}
+	if (!current)
+	{
+		static dictionary builtin = {1, 1, {0}};
+
+		builtin.words = builtin_words;
+		current = &builtin;
+	}
+	current->refs++;
+	return current;
+}
+
+void dictionary_release(dictionary *d)
+{
+	if (--d->refs == 0)
+		dictionary_free(d);
+}
@@ -0,0 +1,74 @@
+/*
+ * dictionary.h: word list of the hangman service
+ *
+ * A dictionary can be replaced while games are running: a new one is
+ * built by any thread with dictionary_load() and handed over with
+ * dictionary_publish(). The event loop picks it up with the next
+ * dictionary_acquire(), no locks are taken. Games keep a reference
+ * to the dictionary their word comes from until they are finished,
+ * the old dictionary is freed with the last reference.
+ */
+
+#ifndef DICTIONARY_H_
+#define DICTIONARY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DICTIONARY_WORDLEN 80	/* buffer size for a word including '\0' */
+#define DICTIONARY_LINELEN 100	/* status line of the service including '\0' */
+#define DICTIONARY_LINE_TAIL "  lives: 10 \n"	/* the most the service prints after a word */
+
+/*
+ * longest word: it needs a buffer of DICTIONARY_WORDLEN and its status
+ * line "<word>  lives: <n> \n" has to fit into DICTIONARY_LINELEN
+ */
+#define DICTIONARY_MAXLETTERS \
+	(DICTIONARY_WORDLEN - 1 < DICTIONARY_LINELEN - sizeof(DICTIONARY_LINE_TAIL) ? \
+	 DICTIONARY_WORDLEN - 1 : DICTIONARY_LINELEN - sizeof(DICTIONARY_LINE_TAIL))
+
+/*
+ * flat table of words, everything a game needs is precomputed
+ */
+typedef struct word_table
+{
+	int count;				/* number of words */
+	const char *text;		/* all words, separated by '\0' */
+	const uint32_t *offset;	/* start of word i in text */
+	const uint8_t *length;	/* length of word i */
+	const uint32_t *mask;	/* letters of word i, see dictionary_letter() */
+} word_table;
+
+/* the compiled in words (words.def), generated at compile time in wordtable.cpp */
+extern const word_table builtin_words;
+
+typedef struct dictionary
+{
+	int refs;			/* references, only touched by the event loop */
+	int builtin;		/* the compiled in word list is never freed */
+	word_table words;
+} dictionary;
+
+/*
+ * bit of letter c in a word mask, 0 for anything but 'a'..'z'
+ */
+static inline uint32_t dictionary_letter(char c)
+{
+	return (c >= 'a' && c <= 'z') ? (uint32_t)1 << (c - 'a') : 0;
+}
+
+/*
+ * any thread
+ */
+dictionary *dictionary_load(const char *path);	/* NULL on error */
+dictionary *dictionary_parse(const char *text, size_t len, const char *name);	/* same from memory */
+void dictionary_publish(dictionary *d);
+void dictionary_free(dictionary *d);
+
+/*
+ * event loop only
+ */
+dictionary *dictionary_acquire(void);	/* current dictionary, one reference more */
+void dictionary_release(dictionary *d);
+
+#endif
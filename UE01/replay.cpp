@@ -0,0 +1,139 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+#include <unistd.h>
+
+
+extern "C" {
+    #include "service.h"
+    #include "trace.h"
+    #include "dictionary.h"
+}
+
+// Spielt einen mit "HWP-select-server -t" aufgenommenen Trace ohne Sockets
+// gegen service_init/service_do/service_exit ab, so schnell wie möglich.
+
+static trace_reader reader;
+static trace_record pending_read;   // Daten für den nächsten read() des Service
+static time_t replay_time;          // Zeit, die service_init sieht
+static long write_mismatches = 0;
+
+static ssize_t replay_read(int, void *buf, size_t count) {
+    size_t n = std::min(count, pending_read.len);
+    memcpy(buf, pending_read.data, n);
+    return pending_read.value < 0 ? pending_read.value : static_cast<ssize_t>(n);
+}
+
+// jeder write des Service muss dem nächsten aufgezeichneten WRITE entsprechen
+static ssize_t replay_write(int fd, const void *buf, size_t count) {
+    trace_reader peek = reader;
+    trace_record rec;
+    if (trace_next(&peek, &rec) == 1 && rec.type == TRACE_WRITE && rec.fd == fd &&
+        rec.len == count && memcmp(rec.data, buf, count) == 0) {
+        reader = peek; // aufgezeichneten WRITE verbrauchen
+        return rec.value;
+    }
+    write_mismatches++;
+    return static_cast<ssize_t>(count);
+}
+
+static time_t replay_clock(time_t *timer) {
+    if (timer) *timer = replay_time;
+    return replay_time;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:")) != -1) {
+        if (opt == 'n') {
+            iterations = atoi(optarg); // -n: Trace mehrmals abspielen
+        } else if (opt == 'w') {
+            dictionary *d = dictionary_load(optarg); // für Traces ohne Wörter: gleiche Datei wie der aufnehmende Server
+            if (!d) return 1;
+            dictionary_publish(d);
+        } else {
+            iterations = 0;
+            break;
+        }
+    }
+    if (optind != argc - 1 || iterations < 1) {
+        std::cerr << "usage: " << argv[0] << " [-n iterations] [-w wordfile] tracefile" << std::endl;
+        return 1;
+    }
+
+    if (trace_load(&reader, argv[optind]) < 0) {
+        std::cerr << "cannot load trace " << argv[optind] << std::endl;
+        return 1;
+    }
+
+    static const service_io replay_io = {replay_read, replay_write, replay_clock};
+    service_set_io(&replay_io);
+
+    using clock = std::chrono::steady_clock;
+    long events = 0, calls = 0, unexpected = 0;
+    clock::duration busy{}, worst{};
+
+    for (int i = 0; i < iterations; i++) {
+        std::set<int> open_fds;
+        trace_rewind(&reader);
+        srand(reader.seed); // gleiche Wortwahl wie beim Aufzeichnen
+
+        trace_record rec;
+        int status;
+        while ((status = trace_next(&reader, &rec)) == 1) {
+            events++;
+            auto start = clock::now();
+            switch (rec.type) {
+            case TRACE_ACCEPT:
+                replay_time = static_cast<time_t>(rec.value);
+                service_init(rec.fd);
+                open_fds.insert(rec.fd);
+                break;
+            case TRACE_READ:
+                pending_read = rec;
+                service_do(rec.fd);
+                break;
+            case TRACE_WRITE:
+                unexpected++; // Service hat diesen write nicht mehr gemacht
+                continue;
+            case TRACE_DISCONNECT:
+                service_exit(rec.fd);
+                open_fds.erase(rec.fd);
+                break;
+            case TRACE_DICTIONARY: { // Aufnahmebeginn oder SIGHUP: neue Spiele nehmen diese Wörter
+                dictionary *d = dictionary_parse(reinterpret_cast<const char *>(rec.data), rec.len, argv[optind]);
+                if (!d) return 1;
+                dictionary_publish(d);
+                continue;
+            }
+            }
+            auto took = clock::now() - start;
+            busy += took;
+            worst = std::max(worst, took);
+            calls++;
+        }
+        if (status < 0) {
+            std::cerr << "corrupt trace at offset " << reader.pos << std::endl;
+            return 1;
+        }
+        for (int fd : open_fds) { // abgebrochene Aufnahme: offene Clients aufräumen
+            service_exit(fd);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(busy).count();
+    std::cout << "events:       " << events << std::endl;
+    std::cout << "calls:        " << calls << std::endl;
+    std::cout << "time:         " << seconds << " s" << std::endl;
+    std::cout << "calls/s:      " << (seconds > 0 ? calls / seconds : 0) << std::endl;
+    std::cout << "mean:         " << (calls ? seconds * 1e9 / calls : 0) << " ns" << std::endl;
+    std::cout << "worst:        " << std::chrono::duration<double, std::nano>(worst).count() << " ns" << std::endl;
+    std::cout << "mismatches:   " << write_mismatches + unexpected << std::endl;
+
+    trace_unload(&reader);
+    return (write_mismatches + unexpected) ? 2 : 0;
+}
@@ -1,28 +1,111 @@
+#include <algorithm>
 #include <iostream>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <atomic>
+#include <string>
+#include <thread>
 
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
 
+#include "websocket.h"
 
 extern "C" {
     #include "service.h"
+    #include "trace.h"
+    #include "dictionary.h"
 }
 
-static int next_pending_connection(int server_sock) { // Funktion kann man von außen nciht referenzieren
-    int fd = accept(server_sock, nullptr, nullptr);
-    std::cout << "\nAccepted connection" << std::endl;
-    return fd;
+static volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t reload_requested = 0;
+static time_t accept_time; // Zeit, die service_init beim Aufzeichnen sieht
+
+static void request_stop(int) {
+    stop_requested = 1;
 }
 
-int main() {
-    std::cout << "Select Server" << std::endl;
+static void request_reload(int) {
+    reload_requested = 1;
+}
+
+// Wörterbuch außerhalb der Event-Loop neu laden; laufende Spiele behalten ihr altes.
+// Es gibt höchstens einen Loader, sein Ergebnis übernimmt die Event-Loop über die Pipe
+static std::thread loader;
+static std::atomic<dictionary *> loaded{nullptr};
+static int loaded_pipe[2] = {-1, -1};
 
+static void reload_dictionary(const char *path) {
+    if (loader.joinable()) {
+        std::cerr << "SIGHUP ignored, still loading " << path << std::endl;
+        return;
+    }
+    loader = std::thread([path] {
+        dictionary *d = dictionary_load(path);
+        if (!d) {
+            std::cerr << "Keeping dictionary, could not load " << path << std::endl;
+        }
+        loaded.store(d);
+        char done = 0;
+        write(loaded_pipe[1], &done, 1); // weckt die Event-Loop
+    });
+}
+
+// Wörter neuer Spiele in den Trace, damit der Replay dieselben wählt
+static void trace_words(const dictionary *d) {
+    if (!trace_active()) return;
+    std::string words;
+    for (int i = 0; i < d->words.count; i++) {
+        words.append(d->words.text + d->words.offset[i], d->words.length[i]);
+        words += '\n';
+    }
+    trace_dictionary(words.data(), words.size());
+}
+
+// Event-Loop: fertigen Loader einsammeln und sein Wörterbuch veröffentlichen
+static void reload_done(const char *path) {
+    char done;
+    read(loaded_pipe[0], &done, 1);
+    loader.join();
+    dictionary *d = loaded.exchange(nullptr);
+    if (d) {
+        auto count = d->words.count;
+        trace_words(d);
+        dictionary_publish(d);
+        std::cout << "Reloaded " << count << " words from " << path << std::endl;
+    }
+}
+
+// I/O des Service: WebSocket-Clients bekommen Frames, alle anderen den rohen Socket.
+// Ohne -t sind die trace_* Aufrufe wirkungslos
+static ssize_t server_read(int fd, void *buf, size_t count) {
+    ssize_t n = ws_is_websocket(fd) ? ws_read(fd, buf, count) : read(fd, buf, count);
+    trace_read(fd, buf, n);
+    return n;
+}
+
+static ssize_t server_write(int fd, const void *buf, size_t count) {
+    ssize_t n = ws_is_websocket(fd) ? ws_write(fd, buf, count) : write(fd, buf, count);
+    trace_write(fd, buf, count, n);
+    return n;
+}
+
+static time_t server_time(time_t *timer) {
+    if (timer) *timer = accept_time;
+    return accept_time;
+}
+
+// Listen Socket auf port, -1 bei Fehler
+static int listen_on(int port) {
     int sock = socket(AF_INET, SOCK_STREAM, 0);
 
     if (sock < 0) {
         perror("Socket creation failed");
-        return 1;
+        return -1;
     }
 
     int yes = 1;
@@ -31,17 +114,101 @@ int main() {
     sockaddr_in server{};
     server.sin_family = AF_INET;
     server.sin_addr.s_addr = INADDR_ANY; // wir hören auf jede Netzwerkschnittstelle
-    server.sin_port = htons(8000); // muss man wegen endian machen
+    server.sin_port = htons(port); // muss man wegen endian machen
 
     if (bind(sock, reinterpret_cast<sockaddr *>(&server), sizeof(server)) < 0) { // bindet man auf port, wenn belegt dann Fehler
         perror("Bind failed");
-        return 1;
+        close(sock);
+        return -1;
     };
 
-    std::cout << "Bound to port 8000" << std::endl;
+    std::cout << "Bound to port " << port << std::endl;
 
     if (listen(sock, 10) != 0 ) { // wir warten auf Verbindung, man kann maximal 10 Verbindungen abarbeiten
         perror("Listen failed");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static int next_pending_connection(int server_sock) { // Funktion kann man von außen nciht referenzieren
+    int fd = accept(server_sock, nullptr, nullptr);
+    std::cout << "\nAccepted connection" << std::endl;
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "Select Server" << std::endl;
+
+    const char *trace_path = nullptr;
+    const char *words_path = nullptr;
+    int ws_port = 0; // WebSocket nur mit -W
+    int opt;
+    while ((opt = getopt(argc, argv, "t:w:W:")) != -1) {
+        if (opt == 't') {
+            trace_path = optarg; // -t <datei>: alle Sessions aufzeichnen
+        } else if (opt == 'w') {
+            words_path = optarg; // -w <datei>: Wörter aus Datei, SIGHUP lädt neu
+        } else if (opt == 'W') {
+            ws_port = atoi(optarg); // -W <port>: WebSocket-Port für Browser, z.B. 8001
+        } else {
+            std::cerr << "usage: " << argv[0] << " [-t tracefile] [-w wordfile] [-W websocketport]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (words_path) {
+        dictionary *d = dictionary_load(words_path);
+        if (!d) {
+            return 1;
+        }
+        dictionary_publish(d);
+    }
+
+    if (trace_path) {
+        unsigned int seed = static_cast<unsigned int>(time(nullptr));
+        if (trace_open(trace_path, seed) < 0) {
+            perror("Trace open failed");
+            return 1;
+        }
+        srand(seed); // Seed steht im Trace, damit der Replay dieselben Wörter wählt
+        std::cout << "Recording trace to " << trace_path << std::endl;
+        dictionary *d = dictionary_acquire(); // Wörter, mit denen die Aufnahme beginnt
+        trace_words(d);
+        dictionary_release(d);
+    }
+
+    // SIGINT/SIGTERM beenden die Schleife sauber, damit der Trace geschrieben wird
+    struct sigaction sa{};
+    sa.sa_handler = request_stop;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    signal(SIGPIPE, SIG_IGN); // Client weg: write liefert EPIPE statt den Server zu beenden
+    sa.sa_handler = request_reload;
+    sigaction(SIGHUP, &sa, nullptr);
+    // Signale kommen nur während pselect an, dort ohne Lücke zwischen Prüfen und Warten
+    sigset_t blocked, wait_mask;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    sigaddset(&blocked, SIGHUP);
+    sigprocmask(SIG_BLOCK, &blocked, &wait_mask); // auch der Loader-Thread erbt die Maske
+
+    if (pipe(loaded_pipe) < 0) {
+        perror("Pipe failed");
+        return 1;
+    }
+
+    static const service_io server_io = {server_read, server_write, server_time};
+    service_set_io(&server_io);
+
+    int sock = listen_on(8000);
+    if (sock < 0) {
+        return 1;
+    }
+    int ws_sock = -1; // Browser sprechen WebSocket auf einem eigenen Port
+    if (ws_port && (ws_sock = listen_on(ws_port)) < 0) {
         return 1;
     }
 
@@ -51,48 +218,111 @@ int main() {
     FD_ZERO(&fds); // File deskriptoren leeren
     FD_SET(sock, &fds); // Listen Socket in die Menge aufnehmen
     int max_fd = sock; // Listen Socket ist nun max_fd --> höchster FD
+    FD_SET(loaded_pipe[0], &fds); // Loader fertig
+    max_fd = std::max(loaded_pipe[0], max_fd);
+    if (ws_sock >= 0) {
+        FD_SET(ws_sock, &fds);
+        max_fd = std::max(ws_sock, max_fd);
+    }
+
+    // Client beenden: Service aufräumen, Socket schließen, nicht mehr überwachen
+    auto disconnect = [&](int fd, bool started) {
+        if (started) {
+            service_exit(fd); // Aufräumen, evtl. Resourcen freigeben
+            trace_disconnect(fd);
+        }
+        ws_close(fd);
+
+        std::cout << "client disconnected" << std::endl;
+        close(fd); // Socket schließen
+
+        FD_CLR(fd, &fds); // Socket nicht mehr überwachen
+
+        if (max_fd == fd) { // max fd muss neu berechnet werden falls der aktuelle socket der max fd socket ist
+            int new_max_fd = std::max({sock, ws_sock, loaded_pipe[0]}); // Listening Sockets und Loader-Pipe
+            for (int i = 2; i < max_fd; ++i) {
+                if (FD_ISSET(i, &fds)) { // FD noch in Überweachungsmenge?
+                    new_max_fd = std::max(new_max_fd, i); // wenn ja dann schauen ob der socket größer als new_max_fd ist
+
+                }
+            }
+            max_fd = new_max_fd; // max_fd neu setzen
+        }
+    };
+
+    while (!stop_requested) {
+        if (reload_requested) { // jede Runde prüfen, nicht nur nach EINTR
+            reload_requested = 0;
+            if (words_path) {
+                reload_dictionary(words_path);
+            } else {
+                std::cerr << "SIGHUP ignored, no word file given (-w)" << std::endl;
+            }
+        }
 
-    while (true) {
         fd_set read_fds = fds;
-        // Menge aller Sockets die überwacht werden. Blockeirt bis mindestens 1 Socket bereit ist
-        if (select(max_fd + 1, &read_fds, nullptr, nullptr, nullptr) < 0) { // schaut sich höchsten filedescriptor an. read_fds ist Menge an fds. nfds braucht man weil fd_set ein bit array hat und wissen muss wie viel bit es sich anschauen muss
+        // Menge aller Sockets die überwacht werden. Blockeirt bis mindestens 1 Socket bereit ist oder ein Signal kommt
+        if (pselect(max_fd + 1, &read_fds, nullptr, nullptr, nullptr, &wait_mask) < 0) { // schaut sich höchsten filedescriptor an. read_fds ist Menge an fds. nfds braucht man weil fd_set ein bit array hat und wissen muss wie viel bit es sich anschauen muss
+            if (errno == EINTR) { // Signal, Schleifenbedingung prüfen
+                continue;
+            }
             perror("Select failed");
-            return 1;
-        }; 
+            break;
+        }
 
         for (int fd = 2; fd <= max_fd; fd++) { // ersten 2 überwacht man nicht (0 = stdin, 1 = stdout)
             if (FD_ISSET(fd, &read_fds)) { // prüfe ob select diesen socket als bereit markiert hat
-                if (fd == sock) { // wenn es listening socket ist dann gibt es neue Verbindung
+                if (fd == loaded_pipe[0]) {
+                    reload_done(words_path);
+                } else if (fd == sock) { // wenn es listening socket ist dann gibt es neue Verbindung
                     int client_fd = next_pending_connection(sock); // akzeptiere Verbindung
                     FD_SET(client_fd, &fds); // füge neuen Client sock zu fds hinu
                     max_fd = std::max(client_fd, max_fd); // neuer sock ist max 
 
+                    accept_time = time(nullptr);
+                    trace_accept(client_fd, accept_time);
                     service_init(client_fd); // starte service für diesen client
+                } else if (fd == ws_sock) { // Browser: Service startet erst nach dem Handshake
+                    int client_fd = next_pending_connection(ws_sock);
+                    if (client_fd >= FD_SETSIZE) { // passt nicht ins fd_set
+                        close(client_fd);
+                        continue;
+                    }
+                    FD_SET(client_fd, &fds);
+                    max_fd = std::max(client_fd, max_fd);
+                    ws_accept(client_fd);
+                } else if (ws_is_websocket(fd)) {
+                    bool open = ws_is_open(fd);
+                    if (!ws_receive(fd)) {
+                        disconnect(fd, open);
+                        continue;
+                    }
+                    // ein read kann mehrere Frames enthalten, alle abarbeiten
+                    for (ws_event ev; (ev = ws_next(fd)) != WS_AGAIN; ) {
+                        if (ev == WS_OPEN) {
+                            accept_time = time(nullptr);
+                            trace_accept(fd, accept_time);
+                            service_init(fd);
+                            open = true;
+                        } else if (ev == WS_CLOSE || service_do(fd) == 0) {
+                            disconnect(fd, open);
+                            break;
+                        }
+                    }
                 } else { // Client Socket ist wieder bereit (frei, also fertig
                     if (service_do(fd) == 0) { // Client fertig, Verbindung geschlossen
-                        service_exit(fd); // Aufräumen, evtl. Resourcen freigeben
-
-                        std::cout << "client disconnected" << std::endl;
-                        close(fd); // Socket schließen
-
-                        FD_CLR(fd, &fds); // Socket nicht mehr überwachen
-
-                        if (max_fd == fd) { // max fd muss neu berechnet werden falls der aktuelle socket der max fd socket ist
-                            int new_max_fd = sock; // Listening Socket
-                            for (int i = 2; i < max_fd; ++i) {
-                                if (FD_ISSET(i, &fds)) { // FD noch in Überweachungsmenge?
-                                    new_max_fd = std::max(new_max_fd, i); // wenn ja dann schauen ob der socket größer als new_max_fd ist
-                            
-                                }
-                            }
-                            max_fd = new_max_fd; // max_fd neu setzen
-                        }
-
+                        disconnect(fd, true);
                     }
                 }
             }
         }
     }
-    
-    return 0;
+
+    if (loader.joinable()) { // laufenden Loader abwarten, sein Ergebnis wird nicht mehr gebraucht
+        loader.join();
+    }
+    dictionary_free(loaded.exchange(nullptr));
+    trace_close();
+    std::cout << "\nServer stopped" << std::endl;
+    return stop_requested ? 0 : 1;
 }
\ No newline at end of file
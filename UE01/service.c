@@ -12,6 +12,7 @@
 #include <unistd.h>
 
 #include "service.h"
+#include "dictionary.h"
 
 /*
  * remove the following define if you are not
@@ -19,16 +20,18 @@
  */
 // #define DEBUG
 
-#define WORDLEN 80
-#define MAXOUTPUT_LEN (WORDLEN + 20)
+#define WORDLEN DICTIONARY_WORDLEN
+#define MAXOUTPUT_LEN DICTIONARY_LINELEN
 #define INCOMPLETE 1
 #define WON 2
 #define LOST 3
 
 typedef struct state
 {
-	char *whole_word; /* the word to be guessed */
+	dictionary *dict; /* the dictionary whole_word belongs to */
+	const char *whole_word; /* the word to be guessed */
 	int word_len;
+	uint32_t letters; /* letters in whole_word, see dictionary_letter() */
 	char part_word[WORDLEN]; /* the part guessed already */
 	int lives;
 	int fd;				/* file descriptor of client */
@@ -37,40 +40,18 @@ typedef struct state
 
 static state *clients = NULL;
 
-static char *words[] = {/* the words to be guessed */
-						"applicationlayer",
-						"presentationlayer",
-						"sessionlayer",
-						"transportlayer",
-						"datalinklayer",
-						"networklayer",
-						"physicallayer",
-						"transmissioncontrolprotocol",
-						"userdatagramprotocol",
-
-						"arpa",
-						"internet",
-						"rfc",
-						"addressresolutionprotocol"
-						"reverseaddressresolutionprotocol",
-						"fragmentation",
-						"networkaccesslayer",
-						"internetcontrolmessageprotocol",
-						"filetransferprotocol",
-						"hypertexttransferprotocol",
-						"simplemailtransferprotocol",
-						"networknewsprotocol",
-
-						"asterix",
-						"obelix",
-						"miraculix",
-						"idefix",
-						"majestix",
-						"gutemine",
-						"methusalix",
-						"verleihnix",
-						"troubardix"};
-static char outbuff[WORDLEN];
+static char outbuff[MAXOUTPUT_LEN];
+
+static const service_io default_io = {read, write, time};
+static service_io io = {read, write, time};
+
+/*
+ * replace the I/O primitives of the service
+ */
+void service_set_io(const service_io *new_io)
+{
+	io = new_io ? *new_io : default_io;
+}
 
 /*
  * debug print of list clients
@@ -105,6 +86,7 @@ static state *store(int fd)
 #endif
 
 	aState->fd = fd;
+	aState->dict = NULL;
 	aState->next = clients;
 	clients = aState;
 	print();
@@ -154,6 +136,8 @@ static void removeClient(int fd)
 		prev->next = act->next;
 	}
 
+	if (act->dict)
+		dictionary_release(act->dict);
 	free(act);
 	print();
 }
@@ -167,7 +151,7 @@ void service_init(int fd)
 	static struct tm *t = NULL;
 
 	state *act;
-	int i;
+	int i, pick;
 
 	act = store(fd);
 	act->lives = 10;
@@ -180,11 +164,13 @@ void service_init(int fd)
 	/*
 	 * pick up a random word
 	 */
-	time(&timer);
+	io.time(&timer);
 	t = localtime(&timer);
-	act->whole_word = words[(t->tm_sec + rand()) %
-							(sizeof(words) / sizeof(char *))];
-	act->word_len = strlen(act->whole_word);
+	act->dict = dictionary_acquire();
+	pick = (t->tm_sec + rand()) % act->dict->words.count;
+	act->whole_word = act->dict->words.text + act->dict->words.offset[pick];
+	act->word_len = act->dict->words.length[pick];
+	act->letters = act->dict->words.mask[pick];
 
 	/*
 	 * initialize empty word
@@ -197,7 +183,7 @@ void service_init(int fd)
 	 * output empty word
 	 */
 	snprintf(outbuff, MAXOUTPUT_LEN, "%s  lives:%d \n", act->part_word, act->lives);
-	write(fd, outbuff, strlen(outbuff));
+	io.write(fd, outbuff, strlen(outbuff));
 } 
 
 /*
@@ -212,17 +198,21 @@ int service_do(int fd)
 
 	act = get(fd);
 
-	readCount = read(fd, guess_word, WORDLEN);
+	readCount = io.read(fd, guess_word, WORDLEN);
 
 	hits = 0;
-	for (i = 0; i < act->word_len; i++)
+	if (act->letters & dictionary_letter(guess_word[0]))
 	{
-		if (guess_word[0] == act->whole_word[i])
+		/* the letter occurs in the word, uncover it */
+		for (i = 0; i < act->word_len; i++)
 		{
-			hits = 1;
-			act->part_word[i] = act->whole_word[i];
+			if (guess_word[0] == act->whole_word[i])
+			{
+				hits = 1;
+				act->part_word[i] = act->whole_word[i];
+			} 
 		} 
-	} 
+	}
 
 	/*
 	 * check for end of game
@@ -239,7 +229,7 @@ int service_do(int fd)
 	{
 		game_status = WON;
 		sprintf(outbuff, "You won!\n");
-		write(fd, outbuff, strlen(outbuff));
+		io.write(fd, outbuff, strlen(outbuff));
 		return 0;
 	}
 	else if (act->lives == 0)
@@ -251,11 +241,11 @@ int service_do(int fd)
 	 * show word
 	 */
 	snprintf(outbuff, MAXOUTPUT_LEN, "%s  lives: %d \n", act->part_word, act->lives);
-	write(fd, outbuff, strlen(outbuff));
+	io.write(fd, outbuff, strlen(outbuff));
 	if (game_status == LOST)
 	{
 		sprintf(outbuff, "\nGame over.\n");
-		write(fd, outbuff, strlen(outbuff));
+		io.write(fd, outbuff, strlen(outbuff));
 	} 
 
 	if (game_status == INCOMPLETE)
@@ -2,6 +2,28 @@
  * service.h: define interface of service module
  */
 
+#ifndef SERVICE_H_
+#define SERVICE_H_
+
+#include <sys/types.h>
+#include <time.h>
+
 void service_init(int fd);	/* insert a new client for service */
 int  service_do(int fd);	/* do a service on client fd */
 void service_exit(int fd);	/* remove the client fd from service */
+
+/*
+ * I/O primitives used by the service. By default these are
+ * read(2), write(2) and time(2); the server replaces them to
+ * record a trace, the replay tool to run without sockets.
+ */
+typedef struct service_io
+{
+	ssize_t (*read)(int fd, void *buf, size_t count);
+	ssize_t (*write)(int fd, const void *buf, size_t count);
+	time_t (*time)(time_t *timer);
+} service_io;
+
+void service_set_io(const service_io *io);	/* NULL restores the defaults */
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * trace.c -- compact binary trace of server sessions
+ *
+ * File layout: "HWPT", version byte, seed (4 bytes little endian),
+ * followed by records:
+ *   type (1 byte), fd, time delta in ns, value (zigzag), len, data
+ * all numbers except the type are unsigned LEB128 varints.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "trace.h"
+
+#define TRACE_MAGIC "HWPT"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_LEN 9
+#define TRACE_FILE_BUFFER (64 * 1024)
+
+static FILE *trace_file = NULL;
+static uint64_t trace_last;		/* time stamp of the previous record */
+
+/*
+ * monotonic clock in ns
+ */
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void put_varint(uint64_t v)
+{
+	while (v >= 0x80)
+	{
+		putc((int)(v & 0x7f) | 0x80, trace_file);
+		v >>= 7;
+	}
+	putc((int)v, trace_file);
+}
+
+static void put_record(int type, int fd, int64_t value,
+					   const void *data, size_t len)
+{
+	uint64_t now = now_ns();
+
+	putc(type, trace_file);
+	put_varint((uint64_t)fd);
+	put_varint(now - trace_last);
+	put_varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+	put_varint(len);
+	if (len)
+		fwrite(data, 1, len, trace_file);
+	trace_last = now;
+}
+
+/*
+ * start recording into path
+ */
+int trace_open(const char *path, unsigned int seed)
+{
+	unsigned char header[TRACE_HEADER_LEN];
+	int i;
+
+	trace_close();
+	trace_file = fopen(path, "wb");
+	if (!trace_file)
+		return -1;
+	setvbuf(trace_file, NULL, _IOFBF, TRACE_FILE_BUFFER);
+
+	memcpy(header, TRACE_MAGIC, 4);
+	header[4] = TRACE_VERSION;
+	for (i = 0; i < 4; i++)
+		header[5 + i] = (seed >> (8 * i)) & 0xff;
+	fwrite(header, 1, sizeof(header), trace_file);
+	trace_last = now_ns();
+	return 0;
+}
+
+void trace_close(void)
+{
+	if (trace_file)
+	{
+		fclose(trace_file);
+		trace_file = NULL;
+	}
+}
+
+int trace_active(void)
+{
+	return trace_file != NULL;
+}
+
+void trace_accept(int fd, time_t now)
+{
+	if (trace_file)
+		put_record(TRACE_ACCEPT, fd, (int64_t)now, NULL, 0);
+}
+
+void trace_read(int fd, const void *buf, ssize_t n)
+{
+	if (trace_file)
+		put_record(TRACE_READ, fd, n, buf, n > 0 ? (size_t)n : 0);
+}
+
+void trace_write(int fd, const void *buf, size_t count, ssize_t n)
+{
+	if (trace_file)
+		put_record(TRACE_WRITE, fd, n, buf, count);
+}
+
+void trace_disconnect(int fd)
+{
+	if (trace_file)
+	{
+		put_record(TRACE_DISCONNECT, fd, 0, NULL, 0);
+		fflush(trace_file);		/* a session is complete, keep it */
+	}
+}
+
+void trace_dictionary(const char *words, size_t len)
+{
+	if (trace_file)
+		put_record(TRACE_DICTIONARY, 0, 0, words, len);
+}
+
+/*
+ * load a whole trace into memory
+ */
+int trace_load(trace_reader *r, const char *path)
+{
+	FILE *f;
+	long size;
+
+	memset(r, 0, sizeof(*r));
+	f = fopen(path, "rb");
+	if (!f)
+		return -1;
+	if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < TRACE_HEADER_LEN)
+	{
+		fclose(f);
+		return -1;
+	}
+	rewind(f);
+
+	r->buffer = (unsigned char *)malloc(size);
+	if (!r->buffer || fread(r->buffer, 1, size, f) != (size_t)size ||
+		memcmp(r->buffer, TRACE_MAGIC, 4) != 0 ||
+		r->buffer[4] != TRACE_VERSION)
+	{
+		fclose(f);
+		trace_unload(r);
+		return -1;
+	}
+	fclose(f);
+
+	r->len = size;
+	r->seed = r->buffer[5] | (r->buffer[6] << 8) | (r->buffer[7] << 16) |
+			  ((unsigned int)r->buffer[8] << 24);
+	trace_rewind(r);
+	return 0;
+}
+
+void trace_rewind(trace_reader *r)
+{
+	r->pos = TRACE_HEADER_LEN;
+	r->timestamp = 0;
+}
+
+static int get_varint(trace_reader *r, uint64_t *v)
+{
+	int shift;
+
+	*v = 0;
+	for (shift = 0; shift < 64 && r->pos < r->len; shift += 7)
+	{
+		unsigned char b = r->buffer[r->pos++];
+
+		*v |= (uint64_t)(b & 0x7f) << shift;
+		if (!(b & 0x80))
+			return 1;
+	}
+	return 0;
+}
+
+int trace_next(trace_reader *r, trace_record *rec)
+{
+	uint64_t fd, delta, value, len;
+
+	if (r->pos >= r->len)
+		return 0;
+
+	rec->type = r->buffer[r->pos++];
+	if (rec->type < TRACE_ACCEPT || rec->type > TRACE_DICTIONARY ||
+		!get_varint(r, &fd) || !get_varint(r, &delta) ||
+		!get_varint(r, &value) || !get_varint(r, &len) ||
+		len > r->len - r->pos)
+		return -1;
+
+	r->timestamp += delta;
+	rec->fd = (int)fd;
+	rec->timestamp = r->timestamp;
+	rec->value = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	rec->len = len;
+	rec->data = r->buffer + r->pos;
+	r->pos += len;
+	return 1;
+}
+
+void trace_unload(trace_reader *r)
+{
+	free(r->buffer);
+	r->buffer = NULL;
+	r->len = r->pos = 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * trace.h: binary trace of server sessions
+ *
+ * The server records every accept, read, write and disconnect
+ * of the service together with a monotonic time stamp, and the
+ * words new games are picked from whenever they change. The replay
+ * tool feeds such a trace back into the service without sockets.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+enum trace_event
+{
+	TRACE_ACCEPT = 1,	/* value: wall clock seen by service_init */
+	TRACE_READ,			/* value: result of read, data: bytes read */
+	TRACE_WRITE,		/* value: result of write, data: bytes written */
+	TRACE_DISCONNECT,
+	TRACE_DICTIONARY	/* data: words for new games, one per line */
+};
+
+typedef struct trace_record
+{
+	int type;					/* one of enum trace_event */
+	int fd;						/* client file descriptor */
+	uint64_t timestamp;			/* ns since start of trace */
+	int64_t value;
+	size_t len;					/* number of bytes in data */
+	const unsigned char *data;	/* points into the loaded trace */
+} trace_record;
+
+typedef struct trace_reader
+{
+	unsigned char *buffer;
+	size_t len, pos;
+	uint64_t timestamp;
+	unsigned int seed;		/* seed for srand() used while recording */
+} trace_reader;
+
+/*
+ * recording, all functions do nothing if no trace is open
+ */
+int  trace_open(const char *path, unsigned int seed);
+void trace_close(void);
+int  trace_active(void);
+void trace_accept(int fd, time_t now);
+void trace_read(int fd, const void *buf, ssize_t n);
+void trace_write(int fd, const void *buf, size_t count, ssize_t n);
+void trace_disconnect(int fd);
+void trace_dictionary(const char *words, size_t len);
+
+/*
+ * reading, trace_next returns 1 for a record, 0 at the end
+ * and -1 for a corrupt trace
+ */
+int  trace_load(trace_reader *r, const char *path);
+void trace_rewind(trace_reader *r);
+int  trace_next(trace_reader *r, trace_record *rec);
+void trace_unload(trace_reader *r);
+
+#endif
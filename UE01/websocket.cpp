@@ -0,0 +1,321 @@
+#include "websocket.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+
+#include <sys/select.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define WS_BUFFER 2048  // Handshake-Request bzw. ungelesene Frames
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+enum ws_state { WS_NONE = 0, WS_HANDSHAKE, WS_CONNECTED, WS_CLOSING };
+
+struct ws_conn {
+    ws_state state;
+    size_t len;                 // Bytes im Puffer
+    size_t pos;                 // bereits verarbeitet
+    const uint8_t *payload;     // aktuelle Nachricht für ws_read
+    size_t payload_len;
+    uint8_t in[WS_BUFFER];
+};
+
+static ws_conn conns[FD_SETSIZE]; // Index ist der Filedescriptor
+
+// ---------------------------------------------------------------- SHA-1, Base64
+
+static uint32_t rol(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void sha1(const uint8_t *data, size_t len, uint8_t digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t block[64];
+    size_t total = ((len + 8) / 64 + 1) * 64; // mit Padding
+
+    for (size_t offset = 0; offset < total; offset += 64) {
+        for (size_t i = 0; i < 64; i++) {
+            size_t j = offset + i;
+            block[i] = j < len ? data[j] : j == len ? 0x80 : 0;
+        }
+        if (offset + 64 == total) {
+            uint64_t bits = static_cast<uint64_t>(len) * 8;
+            for (int i = 0; i < 8; i++) block[63 - i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++)
+            w[i] = (block[4 * i] << 24) | (block[4 * i + 1] << 16) | (block[4 * i + 2] << 8) | block[4 * i + 3];
+        for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    for (int i = 0; i < 20; i++) digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+// dest braucht 4 * ((len + 2) / 3) + 1 Zeichen
+static void base64(const uint8_t *data, size_t len, char *dest) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < len) v |= data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+        *dest++ = table[(v >> 18) & 0x3f];
+        *dest++ = table[(v >> 12) & 0x3f];
+        *dest++ = i + 1 < len ? table[(v >> 6) & 0x3f] : '=';
+        *dest++ = i + 2 < len ? table[v & 0x3f] : '=';
+    }
+    *dest = '\0';
+}
+
+// ---------------------------------------------------------------- Frames
+
+// Payload in place demaskieren, 16 bzw. 8 Bytes pro Schritt
+static void unmask(uint8_t *p, size_t n, const uint8_t key[4]) {
+    size_t i = 0;
+    uint32_t k32;
+    memcpy(&k32, key, 4);
+#ifdef __SSE2__
+    const __m128i k128 = _mm_set1_epi32(static_cast<int>(k32));
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i), _mm_xor_si128(v, k128));
+    }
+#endif
+    const uint64_t k64 = (static_cast<uint64_t>(k32) << 32) | k32;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v;
+        memcpy(&v, p + i, 8);
+        v ^= k64;
+        memcpy(p + i, &v, 8);
+    }
+    for (; i < n; i++) p[i] ^= key[i & 3];
+}
+
+// Frame vom Server an den Client, ohne Maske, Header und Payload mit einem writev
+static ssize_t send_frame(int fd, uint8_t opcode, const void *data, size_t len) {
+    uint8_t header[10];
+    size_t header_len = 2;
+    header[0] = 0x80 | opcode; // FIN
+    if (len < 126) {
+        header[1] = static_cast<uint8_t>(len);
+    } else if (len <= 0xffff) {
+        header[1] = 126;
+        header[2] = static_cast<uint8_t>(len >> 8);
+        header[3] = static_cast<uint8_t>(len);
+        header_len = 4;
+    } else {
+        header[1] = 127;
+        for (int i = 0; i < 8; i++) header[2 + i] = static_cast<uint8_t>(static_cast<uint64_t>(len) >> (56 - 8 * i));
+        header_len = 10;
+    }
+    iovec iov[2] = {{header, header_len}, {const_cast<void *>(data), len}};
+    ssize_t n = writev(fd, iov, len ? 2 : 1);
+    return n < 0 ? n : n - static_cast<ssize_t>(header_len);
+}
+
+static void send_close(int fd, uint16_t code) {
+    uint8_t payload[2] = {static_cast<uint8_t>(code >> 8), static_cast<uint8_t>(code)};
+    send_frame(fd, 0x8, payload, sizeof(payload));
+}
+
+// ---------------------------------------------------------------- Handshake
+
+// Wert des Headers name (ohne ':'), case-insensitive; Länge in value_len
+static const char *header_value(const char *request, const char *name, size_t *value_len) {
+    size_t name_len = strlen(name);
+    for (const char *line = strstr(request, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            const char *end = strstr(value, "\r\n");
+            *value_len = end ? static_cast<size_t>(end - value) : strlen(value);
+            while (*value_len && (value[*value_len - 1] == ' ' || value[*value_len - 1] == '\t')) (*value_len)--;
+            return value;
+        }
+    }
+    return nullptr;
+}
+
+static bool contains_token(const char *value, size_t len, const char *token) {
+    size_t token_len = strlen(token);
+    for (size_t i = 0; i + token_len <= len; i++)
+        if (strncasecmp(value + i, token, token_len) == 0) return true;
+    return false;
+}
+
+static ws_event handshake(int fd, ws_conn &c) {
+    // Request vollständig? Endet mit Leerzeile
+    c.in[c.len] = '\0';
+    const char *request = reinterpret_cast<const char *>(c.in);
+    const char *end = strstr(request, "\r\n\r\n");
+    if (!end) {
+        return WS_AGAIN; // voller Puffer ohne Leerzeile: ws_receive schlägt fehl
+    }
+
+    size_t upgrade_len = 0, key_len = 0;
+    const char *upgrade = header_value(request, "Upgrade", &upgrade_len);
+    const char *key = header_value(request, "Sec-WebSocket-Key", &key_len);
+    if (strncmp(request, "GET ", 4) != 0 || !upgrade || !contains_token(upgrade, upgrade_len, "websocket") ||
+        !key || key_len == 0 || key_len > 64) {
+        static const char bad[] = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        write(fd, bad, sizeof(bad) - 1);
+        return WS_CLOSE;
+    }
+
+    uint8_t accept_src[64 + sizeof(WS_GUID)];
+    memcpy(accept_src, key, key_len);
+    memcpy(accept_src + key_len, WS_GUID, sizeof(WS_GUID) - 1);
+    uint8_t digest[20];
+    sha1(accept_src, key_len + sizeof(WS_GUID) - 1, digest);
+    char accept[29];
+    base64(digest, sizeof(digest), accept);
+
+    char response[160];
+    int n = snprintf(response, sizeof(response),
+                     "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    if (write(fd, response, n) != n) return WS_CLOSE;
+
+    // evtl. schon mitgeschickte Frames bleiben im Puffer
+    c.pos = static_cast<size_t>(end + 4 - request);
+    c.state = WS_CONNECTED;
+    return WS_OPEN;
+}
+
+// ---------------------------------------------------------------- Schnittstelle
+
+void ws_accept(int fd) {
+    ws_conn &c = conns[fd];
+    c.state = WS_HANDSHAKE;
+    c.len = c.pos = 0;
+    c.payload = nullptr;
+    c.payload_len = 0;
+}
+
+bool ws_is_websocket(int fd) {
+    return fd >= 0 && fd < FD_SETSIZE && conns[fd].state != WS_NONE;
+}
+
+bool ws_is_open(int fd) {
+    return ws_is_websocket(fd) && conns[fd].state != WS_HANDSHAKE;
+}
+
+bool ws_receive(int fd) {
+    ws_conn &c = conns[fd];
+    if (c.pos) { // verarbeitete Bytes verwerfen
+        memmove(c.in, c.in + c.pos, c.len - c.pos);
+        c.len -= c.pos;
+        c.pos = 0;
+    }
+    // beim Handshake bleibt Platz für das '\0' des Requests
+    size_t size = c.state == WS_HANDSHAKE ? WS_BUFFER - 1 : WS_BUFFER;
+    if (c.len >= size) return false; // Request bzw. Frame passt nicht in den Puffer
+    ssize_t n = read(fd, c.in + c.len, size - c.len);
+    if (n <= 0) return false;
+    c.len += static_cast<size_t>(n);
+    return true;
+}
+
+ws_event ws_next(int fd) {
+    ws_conn &c = conns[fd];
+    if (c.state == WS_HANDSHAKE) return handshake(fd, c);
+    if (c.state != WS_CONNECTED) return WS_CLOSE;
+
+    while (true) {
+        uint8_t *p = c.in + c.pos;
+        size_t avail = c.len - c.pos;
+        if (avail < 2) return WS_AGAIN;
+
+        uint8_t opcode = p[0] & 0x0f;
+        bool masked = p[1] & 0x80;
+        uint64_t len = p[1] & 0x7f;
+        size_t header = 2;
+        if (len == 126) {
+            if (avail < 4) return WS_AGAIN;
+            len = (p[2] << 8) | p[3];
+            header = 4;
+        } else if (len == 127) {
+            if (avail < 10) return WS_AGAIN;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = (len << 8) | p[2 + i];
+            header = 10;
+        }
+        if (!masked) { // Client-Frames müssen maskiert sein
+            send_close(fd, 1002);
+            c.state = WS_CLOSING;
+            return WS_CLOSE;
+        }
+        if (len > WS_BUFFER - header - 4) {
+            send_close(fd, 1009); // zu groß für den Puffer
+            c.state = WS_CLOSING;
+            return WS_CLOSE;
+        }
+        if (avail < header + 4 + len) return WS_AGAIN;
+
+        uint8_t *payload = p + header + 4;
+        unmask(payload, len, p + header);
+        c.pos += header + 4 + len;
+
+        switch (opcode) {
+        case 0x0: // Fortsetzung: wie eine eigene Nachricht behandeln
+        case 0x1: // Text
+        case 0x2: // Binär
+            if (len == 0) break; // leere Nachricht wäre für den Service ein EOF
+            c.payload = payload;
+            c.payload_len = len;
+            return WS_MESSAGE;
+        case 0x8: // Close: bestätigen
+            send_frame(fd, 0x8, payload, len >= 2 ? 2 : 0);
+            c.state = WS_CLOSING;
+            return WS_CLOSE;
+        case 0x9: // Ping
+            send_frame(fd, 0xA, payload, len);
+            break;
+        case 0xA: // Pong
+            break;
+        default:
+            send_close(fd, 1002);
+            c.state = WS_CLOSING;
+            return WS_CLOSE;
+        }
+    }
+}
+
+void ws_close(int fd) {
+    if (!ws_is_websocket(fd)) return;
+    if (conns[fd].state == WS_CONNECTED) send_close(fd, 1000);
+    conns[fd].state = WS_NONE;
+}
+
+ssize_t ws_read(int fd, void *buf, size_t count) {
+    ws_conn &c = conns[fd];
+    size_t n = count < c.payload_len ? count : c.payload_len;
+    memcpy(buf, c.payload, n);
+    c.payload_len = 0; // jede Nachricht wird nur einmal gelesen
+    return static_cast<ssize_t>(n);
+}
+
+ssize_t ws_write(int fd, const void *buf, size_t count) {
+    return send_frame(fd, 0x1, buf, count);
+}
@@ -0,0 +1,29 @@
+#ifndef WEBSOCKET_H_
+#define WEBSOCKET_H_
+
+#include <cstddef>
+#include <sys/types.h>
+
+// WebSocket-Schicht (RFC 6455) für die Select-Event-Loop.
+// Pro Verbindung gibt es einen festen Puffer, es wird nichts allokiert.
+// Text-Frames werden dem Service wie ein read() auf dem Socket geliefert,
+// Ausgaben des Service werden als Text-Frames verschickt.
+
+enum ws_event {
+    WS_AGAIN,   // mehr Daten nötig
+    WS_OPEN,    // Handshake fertig -> service_init
+    WS_MESSAGE, // Nachricht bereit -> service_do, ws_read liefert sie
+    WS_CLOSE    // Verbindung beenden
+};
+
+void ws_accept(int fd);                 // neue Verbindung auf dem WebSocket-Port
+bool ws_is_websocket(int fd);
+bool ws_is_open(int fd);                // Handshake abgeschlossen
+bool ws_receive(int fd);                // vom Socket lesen, false wenn Verbindung weg
+ws_event ws_next(int fd);               // nächstes Ereignis aus dem Puffer
+void ws_close(int fd);                  // Close-Frame senden (falls offen), Zustand freigeben
+
+ssize_t ws_read(int fd, void *buf, size_t count);         // I/O für den Service
+ssize_t ws_write(int fd, const void *buf, size_t count);
+
+#endif
@@ -0,0 +1,88 @@
+// Erzeugt zur Compile-Zeit aus words.def die Tabelle builtin_words:
+// Text, Offsets, Längen und Buchstabenmasken liegen fertig im Read-only-Speicher,
+// beim Wählen eines Wortes wird nichts mehr berechnet.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+extern "C" {
+    #include "dictionary.h"
+}
+
+namespace {
+
+// Bezeichner statt String-Literale: ein vergessenes Komma kann keine zwei Wörter mehr verbinden
+#define WORD(w) std::string_view(#w),
+constexpr std::string_view words[] = {
+#include "words.def"
+};
+#undef WORD
+
+constexpr std::size_t count = std::size(words);
+
+constexpr std::size_t text_size() {
+    std::size_t size = 0;
+    for (std::string_view w : words) size += w.size() + 1;
+    return size;
+}
+
+constexpr bool all_in_length_limit() {
+    for (std::string_view w : words)
+        if (w.empty() || w.size() > DICTIONARY_MAXLETTERS) return false;
+    return true;
+}
+
+constexpr bool all_lower_case() {
+    for (std::string_view w : words)
+        for (char c : w)
+            if (c < 'a' || c > 'z') return false;
+    return true;
+}
+
+constexpr bool no_duplicates() {
+    for (std::size_t i = 0; i < count; i++)
+        for (std::size_t j = i + 1; j < count; j++)
+            if (words[i] == words[j]) return false;
+    return true;
+}
+
+static_assert(count > 0, "words.def contains no words");
+static_assert(all_in_length_limit(), "every word in words.def needs 1..DICTIONARY_MAXLETTERS letters");
+static_assert(all_lower_case(), "words in words.def may only contain lower case letters");
+static_assert(no_duplicates(), "words.def contains a word twice");
+
+struct table {
+    std::array<char, text_size()> text{};
+    std::array<uint32_t, count> offset{};
+    std::array<uint8_t, count> length{};
+    std::array<uint32_t, count> mask{};
+};
+
+constexpr table build() {
+    table t;
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        t.offset[i] = static_cast<uint32_t>(pos);
+        t.length[i] = static_cast<uint8_t>(words[i].size());
+        for (char c : words[i]) {
+            t.text[pos++] = c;
+            t.mask[i] |= uint32_t{1} << (c - 'a');
+        }
+        t.text[pos++] = '\0';
+    }
+    return t;
+}
+
+constexpr table generated = build();
+
+} // namespace
+
+extern "C" const word_table builtin_words = {
+    static_cast<int>(count),
+    generated.text.data(),
+    generated.offset.data(),
+    generated.length.data(),
+    generated.mask.data(),
+};
@@ -0,0 +1,1440 @@
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "websocket.h"
+
+extern "C" {
+    #include "dictionary.h"
+    #include "plibi_queue.h"
+    #include "plibi_dma.h"
+    #include "plibi_baud.h"
+    #include "plibi_frame.h"
+    #include "plib.h"
+    #include "plibi_date.h"
+    #include "plibi_noise.h"
+    #define PL_PROFILING
+    #include "plib_profile.h"
+    #include "legacy_queue.h"
+    #include "legacy_codec.h"
+    #include "plibi_codec.h"
+    #include "clock_display.h"
+}
+
+// Microbenchmarks der Hot-Functions von UE01 und plib, Ausgabe als JSON.
+// Jeder Benchmark wird so oft wiederholt, bis min_time erreicht ist;
+// gemeldet wird die beste von drei Messungen.
+
+struct Result {
+    std::string name;
+    std::string param;
+    long iterations;
+    double ns_per_op;
+};
+
+static double min_time = 0.1;            // Sekunden pro Messung
+static std::string filter;               // nur Benchmarks, deren Name filter enthält
+static std::vector<Result> results;
+static volatile uint32_t sink;           // verhindert, dass der Compiler Ergebnisse wegoptimiert
+
+// ops: wie viele Operationen ein Aufruf von f ausführt
+static void measure(const std::string &name, const std::string &param, long ops,
+                    const std::function<void(long)> &f) {
+    if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+    using clock = std::chrono::steady_clock;
+    double best = 0;
+    long n = 1;
+    for (int repetition = 0; repetition < 3; repetition++) {
+        while (true) {
+            auto start = clock::now();
+            f(n);
+            double seconds = std::chrono::duration<double>(clock::now() - start).count();
+            if (seconds >= min_time) {
+                double ns = seconds * 1e9 / (static_cast<double>(n) * ops);
+                if (repetition == 0 || ns < best) best = ns;
+                break;
+            }
+            n = seconds > 0 ? std::max(n * 2, static_cast<long>(n * min_time / seconds * 1.2)) : n * 2;
+        }
+    }
+    results.push_back({name, param, n * ops, best});
+    std::cerr << name << " " << param << ": " << best << " ns/op" << std::endl;
+}
+
+static void bench_service() {
+    for (int clients : {1, 10, 100, 1000}) {
+        std::string param = "clients=" + std::to_string(clients);
+        int oldest = BENCH_FIRST_FD; // am Ende der Liste, schlechtester Fall
+        bench_service_populate(clients);
+
+        measure("service/get", param, 1, [&](long n) {
+            for (long i = 0; i < n; i++) sink = bench_service_get(oldest);
+        });
+        measure("service/store_removeClient", param, 1, [&](long n) {
+            for (long i = 0; i < n; i++) bench_service_store_remove(BENCH_FIRST_FD + clients);
+        });
+        measure("service/service_do", param, 1, [&](long n) {
+            for (long i = 0; i < n; i++) sink = bench_service_do(oldest);
+        });
+    }
+    bench_service_clear();
+}
+
+// verbundenes TCP-Paar über Loopback, Nagle aus wie bei kurzen Spielzügen nötig
+static bool tcp_pair(int &client, int &server) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        listen(listener, 1) < 0 || getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &addr_len) < 0) {
+        if (listener >= 0) close(listener);
+        return false;
+    }
+    client = socket(AF_INET, SOCK_STREAM, 0);
+    if (client < 0 || connect(client, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        (server = accept(listener, nullptr, nullptr)) < 0) {
+        if (client >= 0) close(client);
+        close(listener);
+        return false;
+    }
+    close(listener);
+    int one = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return true;
+}
+
+static bool read_full(int fd, uint8_t *buf, size_t len) {
+    while (len) {
+        ssize_t n = read(fd, buf, len);
+        if (n <= 0) return false;
+        buf += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Nachricht hin, gleich lange Antwort zurück: einmal roh über TCP wie auf Port 8000,
+// einmal mit WebSocket-Frames über dieselbe Art Verbindung.
+// Die Differenz ist der Aufwand der WebSocket-Schicht pro Nachricht.
+static void bench_websocket() {
+    auto fail = [](const std::string &what) {
+        std::cerr << "websocket: " << what << std::endl;
+        exit(2);
+    };
+
+    for (size_t size : {8, 1024}) {
+        std::string param = "bytes=" + std::to_string(size);
+        std::vector<uint8_t> message(size, 'a'), reply(size + 4);
+
+        int client, server;
+        if (!tcp_pair(client, server)) fail("no loopback connection");
+        measure("websocket/tcp_roundtrip", param, 1, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                if (write(client, message.data(), size) != static_cast<ssize_t>(size) ||
+                    !read_full(server, reply.data(), size) ||
+                    write(server, reply.data(), size) != static_cast<ssize_t>(size) ||
+                    !read_full(client, reply.data(), size))
+                    fail("tcp roundtrip");
+            }
+        });
+        close(client);
+        close(server);
+
+        if (!tcp_pair(client, server)) fail("no loopback connection");
+        static const char request[] =
+            "GET / HTTP/1.1\r\nHost: bench\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+        ws_accept(server);
+        if (write(client, request, sizeof(request) - 1) != sizeof(request) - 1 || !ws_receive(server) ||
+            ws_next(server) != WS_OPEN)
+            fail("handshake");
+        uint8_t response[256];
+        ssize_t got = read(client, response, sizeof(response));
+        if (got <= 0 || memcmp(response, "HTTP/1.1 101", 12) != 0) fail("handshake response");
+
+        // maskierter Client-Frame, der Server demaskiert im eigenen Puffer
+        static const uint8_t key[4] = {0x37, 0xfa, 0x21, 0x3d};
+        std::vector<uint8_t> frame = {0x81};
+        if (size < 126) {
+            frame.push_back(static_cast<uint8_t>(0x80 | size));
+        } else {
+            frame.insert(frame.end(), {0x80 | 126, static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size)});
+        }
+        frame.insert(frame.end(), key, key + 4);
+        for (size_t i = 0; i < size; i++) frame.push_back(message[i] ^ key[i & 3]);
+        size_t reply_frame = size + (size < 126 ? 2 : 4);
+        std::vector<uint8_t> echo(reply_frame);
+
+        measure("websocket/ws_roundtrip", param, 1, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                if (write(client, frame.data(), frame.size()) != static_cast<ssize_t>(frame.size()))
+                    fail("ws write");
+                ws_event event;
+                while ((event = ws_next(server)) == WS_AGAIN)
+                    if (!ws_receive(server)) fail("ws receive");
+                if (event != WS_MESSAGE || ws_read(server, reply.data(), reply.size()) != static_cast<ssize_t>(size) ||
+                    ws_write(server, reply.data(), size) != static_cast<ssize_t>(size) ||
+                    !read_full(client, echo.data(), reply_frame))
+                    fail("ws roundtrip");
+            }
+        });
+        if (memcmp(echo.data() + reply_frame - size, message.data(), size) != 0) fail("ws echo differs");
+        ws_close(server);
+        close(client);
+        close(server);
+    }
+}
+
+// Wörterliste aus Datei: das längste erlaubte Wort wird ganz gespielt, eines mehr abgelehnt
+static void check_dictionary() {
+    auto fail = [](const std::string &what) {
+        std::cerr << "dictionary: " << what << std::endl;
+        exit(2);
+    };
+    auto load = [&](const std::string &word) {
+        char path[] = "/tmp/hwp-bench-words-XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) fail("no temporary file");
+        std::string line = word + "\n";
+        bool written = write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size());
+        close(fd);
+        dictionary *d = written ? dictionary_load(path) : nullptr;
+        unlink(path);
+        return d;
+    };
+
+    std::string word;
+    for (size_t i = 0; i < DICTIONARY_MAXLETTERS; i++) word += static_cast<char>('a' + i % 26);
+    dictionary *d = load(word + "a");
+    if (d) fail(std::to_string(word.size() + 1) + " letters accepted");
+    if (!(d = load(word))) fail(std::to_string(word.size()) + " letters rejected");
+    dictionary_publish(d);
+
+    char out[4096];
+    std::string game(out, bench_service_game("abcdefghijklmnopqrstuvwxyz", out, sizeof(out)));
+    std::string first = std::string(word.size(), '-') + "  lives:10 \n";
+    if (game.compare(0, first.size(), first) != 0 || game.size() < 9 || game.compare(game.size() - 9, 9, "You won!\n") != 0)
+        fail("game on " + std::to_string(word.size()) + " letters: " + game);
+}
+
+static void bench_queue() {
+    const uint_fast16_t size = 64;
+    uint8_t buffer[size];
+    pli_queue q;
+    pli_queue_init(&q, buffer, size);
+    legacy_queue lq;
+    legacy_queue_init(&lq, buffer, size);
+
+    // bisherige Queue (Modulo, ein Byte pro Aufruf) als Vergleich
+    measure("plib/legacy_enqueue_dequeue", "size=64", size - 1, [&](long n) {
+        uint8_t b = 0;
+        for (long i = 0; i < n; i++) {
+            for (uint_fast16_t j = 0; j < size - 1; j++) legacy_enqueue(&lq, static_cast<uint8_t>(j));
+            for (uint_fast16_t j = 0; j < size - 1; j++) legacy_dequeue(&lq, &b);
+        }
+        sink = b;
+    });
+    measure("plib/pli_enqueue_dequeue", "size=64", size - 1, [&](long n) {
+        uint8_t b = 0;
+        for (long i = 0; i < n; i++) {
+            for (uint_fast16_t j = 0; j < size - 1; j++) pli_enqueue(&q, static_cast<uint8_t>(j));
+            for (uint_fast16_t j = 0; j < size - 1; j++) pli_dequeue(&q, &b);
+        }
+        sink = b;
+    });
+
+    // Blöcke wie eine Nachricht bzw. ein read() des Hosts, über das Pufferende hinweg
+    for (uint_fast16_t chunk : {4, 16, 48}) {
+        uint8_t in[64], out[64];
+        for (uint_fast16_t j = 0; j < chunk; j++) in[j] = static_cast<uint8_t>(j);
+        measure("plib/pli_bulk_enqueue_dequeue", "size=64,chunk=" + std::to_string(chunk), chunk, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                pli_enqueue_bulk(&q, in, chunk);
+                pli_dequeue_bulk(&q, out, chunk);
+            }
+            sink = out[chunk - 1];
+        });
+    }
+
+    // Produzent und Konsument in eigenen Threads wie ISR und Hauptschleife;
+    // die Reihenfolge der Bytes wird geprüft
+    measure("plib/pli_queue_spsc_threads", "size=64", 1, [&](long n) {
+        pli_queue_init(&q, buffer, size);
+        std::thread producer([&] {
+            for (long i = 0; i < n; i++)
+                while (!pli_enqueue(&q, static_cast<uint8_t>(i))) std::this_thread::yield();
+        });
+        uint8_t b;
+        for (long i = 0; i < n; i++) {
+            while (!pli_dequeue(&q, &b)) std::this_thread::yield();
+            if (b != static_cast<uint8_t>(i)) {
+                std::cerr << "pli_queue: byte " << i << " out of order" << std::endl;
+                exit(2);
+            }
+        }
+        producer.join();
+    });
+}
+
+// Simulierter DMA-Kanal für die Verkettung in plibi_dma_tx.c: ein Transfer
+// läuft, bis dma_step() ihn beendet und den Interrupt (pli_dma_tx_complete) auslöst
+static struct {
+    const uint8_t *data;
+    uint_fast16_t len;
+    bool running;
+    long starts;
+    std::vector<uint8_t> sent;
+} dma;
+
+extern "C" void pli_dma_init() {
+}
+
+extern "C" void pli_dma_tx_start(const uint8_t *data, uint_fast16_t len) {
+    if (dma.running || len == 0) {
+        std::cerr << "pli_dma_tx: transfer started " << (len ? "while running" : "without data") << std::endl;
+        exit(2);
+    }
+    dma.data = data;
+    dma.len = len;
+    dma.running = true;
+    dma.starts++;
+}
+
+static bool dma_step(bool record) {
+    if (!dma.running) return false;
+    if (record) dma.sent.insert(dma.sent.end(), dma.data, dma.data + dma.len);
+    dma.running = false;
+    pli_dma_tx_complete();
+    return true;
+}
+
+static void bench_dma() {
+    const uint_fast16_t size = 128;
+    uint8_t buffer[size];
+    pli_queue q;
+
+    // Prüfung: zufällige Folge aus Schreiben und Transferende, alle Bytes
+    // müssen in Reihenfolge und genau einmal beim Kanal ankommen
+    pli_queue_init(&q, buffer, size);
+    pli_dma_tx_init(&q);
+    std::mt19937 rng(1);
+    std::vector<uint8_t> expected;
+    for (int step = 0; step < 200000; step++) {
+        if (rng() % 3) {
+            for (unsigned j = rng() % 20; j > 0 && !pli_queue_full(&q); j--) {
+                uint8_t b = static_cast<uint8_t>(expected.size());
+                pli_enqueue(&q, b);
+                expected.push_back(b);
+                pli_dma_tx_kick();
+            }
+        } else {
+            dma_step(true);
+        }
+    }
+    while (dma_step(true)) {
+    }
+    if (dma.sent != expected || pli_dma_tx_busy()) {
+        std::cerr << "pli_dma_tx: " << dma.sent.size() << " of " << expected.size() << " bytes sent correctly" << std::endl;
+        exit(2);
+    }
+
+    // eine typische Nachricht, byteweise geschrieben wie von send_string(),
+    // dann die Transfers bis zum Leerlauf
+    const char message[] = "d13f3fbf3f\n";
+    const long len = sizeof(message) - 1;
+    measure("plib/dma_tx_message", "len=11", len, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            for (long j = 0; j < len; j++) {
+                pli_enqueue(&q, static_cast<uint8_t>(message[j]));
+                pli_dma_tx_kick();
+            }
+            while (dma_step(false)) {
+            }
+        }
+    });
+    long starts = dma.starts;
+    for (long j = 0; j < len; j++) {
+        pli_enqueue(&q, static_cast<uint8_t>(message[j]));
+        pli_dma_tx_kick();
+    }
+    while (dma_step(false)) {
+    }
+    std::cerr << "plib/dma_tx_message: " << dma.starts - starts << " interrupts instead of " << len << std::endl;
+
+    // bisher: ein TXE-Interrupt pro Byte, der ein Byte aus der Queue nimmt
+    measure("plib/txe_message", "len=11", len, [&](long n) {
+        uint8_t b = 0;
+        for (long i = 0; i < n; i++) {
+            for (long j = 0; j < len; j++) pli_enqueue(&q, static_cast<uint8_t>(message[j]));
+            while (pli_dequeue(&q, &b)) sink = b;
+        }
+    });
+}
+
+// Simulierter UART mit DMA-Empfang für plibi_dma_rx.c: uart_receive() schreibt
+// wie der Kanal in den Ring und löst bei halbem und vollem Ring den Interrupt
+// (pli_dma_rx_poll) aus, uart_idle() entspricht der Idle-Line nach einem Burst
+static struct {
+    uint8_t *ring;
+    uint_fast16_t size;
+    uint_fast16_t pos;
+    long polls;
+} uart;
+
+extern "C" void pli_dma_rx_start(uint8_t *ring, uint_fast16_t size) {
+    uart.ring = ring;
+    uart.size = size;
+    uart.pos = 0;
+}
+
+extern "C" uint_fast16_t pli_dma_rx_position() {
+    return uart.pos;
+}
+
+static void uart_receive(uint8_t b) {
+    uart.ring[uart.pos++] = b;
+    if (uart.pos == uart.size / 2 || uart.pos == uart.size) {
+        uart.polls++;
+        pli_dma_rx_poll();
+    }
+    if (uart.pos == uart.size) uart.pos = 0;
+}
+
+static void uart_idle() {
+    uart.polls++;
+    pli_dma_rx_poll();
+}
+
+static void bench_dma_rx() {
+    const uint_fast16_t size = 256;
+    uint8_t buffer[size];
+    uint8_t ring[64];
+    pli_queue q;
+
+    // Prüfung: Bursts mit verschiedenen Raten, der Empfänger holt pro Schritt
+    // drain Bytes ab. Empfangen + verworfen muss alles Gesendete ergeben,
+    // das Empfangene in Reihenfolge
+    const unsigned drain = 8;
+    for (unsigned rate : {4u, 8u, 16u, 32u, 64u}) {
+        pli_queue_init(&q, buffer, size);
+        pli_dma_rx_init(&q, ring, sizeof(ring));
+        std::mt19937 rng(rate);
+        std::vector<uint8_t> injected, received;
+        long polls = uart.polls;
+        for (int step = 0; step < 100000; step++) {
+            if (rng() % 4 == 0) {
+                // Burst: 1..4 Schritte lang rate Bytes pro Schritt, dann Pause
+                for (unsigned j = rate * (1 + rng() % 4); j > 0; j--) {
+                    uint8_t b = static_cast<uint8_t>(rng());
+                    uart_receive(b);
+                    injected.push_back(b);
+                }
+                uart_idle();
+            }
+            uint8_t b;
+            for (unsigned j = 0; j < drain && pli_dequeue(&q, &b); j++) received.push_back(b);
+        }
+        uint8_t b;
+        while (pli_dequeue(&q, &b)) received.push_back(b);
+
+        size_t k = 0;
+        for (size_t i = 0; i < injected.size() && k < received.size(); i++)
+            if (injected[i] == received[k]) k++;
+        if (k != received.size() || received.size() + pli_dma_rx_drops() != injected.size()) {
+            std::cerr << "pli_dma_rx: rate=" << rate << ": " << received.size() << " received + "
+                      << pli_dma_rx_drops() << " dropped of " << injected.size() << std::endl;
+            exit(2);
+        }
+        std::cerr << "plib/dma_rx rate=" << rate << " drain=" << drain << ": " << injected.size() << " bytes, "
+                  << pli_dma_rx_drops() << " dropped, " << uart.polls - polls << " interrupts" << std::endl;
+    }
+
+    // ein Burst von 11 Bytes (eine Nachricht) bis in die Queue
+    const char message[] = "S1:12:00:00";
+    const long len = sizeof(message) - 1;
+    pli_queue_init(&q, buffer, size);
+    pli_dma_rx_init(&q, ring, sizeof(ring));
+    measure("plib/dma_rx_message", "len=11", len, [&](long n) {
+        uint8_t b = 0;
+        for (long i = 0; i < n; i++) {
+            for (long j = 0; j < len; j++) uart_receive(static_cast<uint8_t>(message[j]));
+            uart_idle();
+            while (pli_dequeue(&q, &b)) sink = b;
+        }
+    });
+
+    // bisher: ein RXNE-Interrupt pro Byte, der ein Byte in die Queue stellt
+    measure("plib/rxne_message", "len=11", len, [&](long n) {
+        uint8_t b = 0;
+        for (long i = 0; i < n; i++) {
+            for (long j = 0; j < len; j++) pli_enqueue(&q, static_cast<uint8_t>(message[j]));
+            while (pli_dequeue(&q, &b)) sink = b;
+        }
+    });
+}
+
+// Prüfung der BRR-Berechnung: der Teiler muss der beste ganzzahlige sein und
+// sich aus BRR/OVER8 zurückgewinnen lassen, 9600 Baud bei 15 MHz wie bisher 1563
+static void check_baud() {
+    const uint32_t clocks[] = {15000000, 64000000, 4000000, 32768};
+    for (uint32_t clock : clocks) {
+        for (uint32_t baud = 100; baud <= 4000000; baud += baud / 97 + 1) {
+            pli_baud setting;
+            int ok = pli_baud_compute(clock, baud, &setting);
+            uint32_t best = static_cast<uint32_t>((static_cast<uint64_t>(clock) + baud / 2) / baud);
+            double error = (static_cast<double>(clock) / best - baud) / baud;
+            bool reachable = best >= 8 && best <= 0xffff && std::abs(error) <= PLI_BAUD_MAX_ERROR_PPM / 1e6;
+            if (ok != reachable) {
+                std::cerr << "pli_baud: clock=" << clock << " baud=" << baud << " accepted=" << ok << std::endl;
+                exit(2);
+            }
+            if (!ok) continue;
+            uint32_t div = setting.over8 ? ((setting.brr & 0xfff0) | ((setting.brr & 7) << 1)) / 2 : setting.brr;
+            if (div != best || setting.over8 != (div < 16) || (setting.over8 && (setting.brr & 8))
+                    || std::abs(setting.error_ppm - error * 1e6) > 1) {
+                std::cerr << "pli_baud: clock=" << clock << " baud=" << baud << " brr=" << setting.brr
+                          << " over8=" << int(setting.over8) << std::endl;
+                exit(2);
+            }
+        }
+    }
+    pli_baud setting;
+    if (!pli_baud_compute(15000000, 9600, &setting) || setting.brr != 1563 || setting.over8) {
+        std::cerr << "pli_baud: 9600 baud at 15 MHz gives brr=" << setting.brr << std::endl;
+        exit(2);
+    }
+    // 16.28 Takte je Bit: 16.5 ginge nur, wenn BRR bei Oversampling 8 das Bit 0 von USARTDIV hätte
+    if (!pli_baud_compute(15000000, 921600, &setting) || setting.brr != 16 || setting.over8
+            || setting.actual != 937500) {
+        std::cerr << "pli_baud: 921600 baud at 15 MHz gives brr=" << setting.brr
+                  << " over8=" << int(setting.over8) << std::endl;
+        exit(2);
+    }
+    for (uint32_t baud : {9600u, 115200u, 230400u, 460800u, 921600u, 1843200u}) {
+        int ok = pli_baud_compute(15000000, baud, &setting);
+        std::cerr << "plib/baud 15 MHz " << baud << ": brr=" << setting.brr << " over8=" << int(setting.over8)
+                  << " " << setting.error_ppm / 1e4 << " %" << (ok ? "" : " (zu ungenau)") << std::endl;
+    }
+}
+
+// Prüfung der Frames: zufällige Nachrichten (auch packbare mit falschen
+// Hexziffern) müssen nach Senden und Empfangen wieder gleich sein,
+// dazwischen Textzeilen; dann die Bytes auf der Leitung für typische Nachrichten
+static void check_frames() {
+    pli_frame_tx tx;
+    pli_frame_rx rx;
+    uint8_t wire[256];
+    char text[PLI_FRAME_MAX + 1];
+    const char *prefixes[] = {"d1", "d2", "d00", "d01", "d0a", "dL", "?S", "e05"};
+    const char alphabet[] = "0123456789abcdefgz\xc0\xdb";
+
+    pli_frame_tx_init(&tx);
+    pli_frame_rx_init(&rx);
+    bench_plib_take(wire, sizeof(wire));
+    std::mt19937 rng(7);
+    for (int i = 0; i < 100000; i++) {
+        std::string message = prefixes[rng() % 8];
+        for (unsigned j = rng() % 20; j > 0; j--) message += alphabet[rng() % (sizeof(alphabet) - 1)];
+        for (char c : message) pli_frame_tx_put(&tx, c);
+        pli_frame_tx_put(&tx, '\n');
+        size_t n = bench_plib_take(wire, sizeof(wire));
+        std::string line = i % 3 ? "" : "?T\n";   // Textzeilen dürfen dazwischen kommen
+        std::vector<std::string> got;
+        for (char c : line) if (pli_frame_rx_put(&rx, c, text, sizeof(text)) > 0) got.push_back(text);
+        for (size_t k = 0; k < n; k++) if (pli_frame_rx_put(&rx, wire[k], text, sizeof(text)) > 0) got.push_back(text);
+        std::vector<std::string> expected;
+        if (!line.empty()) expected.push_back("?T");
+        expected.push_back(message);
+        if (got != expected || rx.errors) {
+            std::cerr << "pli_frame: " << message << " came back as " << (got.empty() ? "nothing" : got.back()) << std::endl;
+            exit(2);
+        }
+    }
+    // ein gekipptes Bit muss die CRC finden
+    for (char c : std::string("d1000102ff\n")) pli_frame_tx_put(&tx, c);
+    size_t n = bench_plib_take(wire, sizeof(wire));
+    wire[2] ^= 0x10;
+    for (size_t k = 0; k < n; k++) {
+        if (pli_frame_rx_put(&rx, wire[k], text, sizeof(text)) > 0) {
+            std::cerr << "pli_frame: corrupted frame accepted" << std::endl;
+            exit(2);
+        }
+    }
+    if (rx.errors != 1) {
+        std::cerr << "pli_frame: corrupted frame not counted" << std::endl;
+        exit(2);
+    }
+
+    for (const char *m : {"d1000102ff", "d2fffe00010c80t", "d0001", "d0a03ff", "dS1"}) {
+        for (const char *c = m; *c; c++) pli_frame_tx_put(&tx, *c);
+        pli_frame_tx_put(&tx, '\n');
+        std::cerr << "plib/frame " << m << ": " << bench_plib_take(wire, sizeof(wire)) << " bytes instead of "
+                  << strlen(m) + 1 << std::endl;
+    }
+}
+
+// Codec: vollständiger Vergleich mit den bisherigen Funktionen, dann beide messen
+static void check_codec() {
+    auto fail = [](const std::string &what) {
+        std::cerr << "plib/codec: " << what << std::endl;
+        exit(2);
+    };
+    char a[9] = {}, b[9] = {};
+    uint32_t va = 0, vb = 0;
+    for (uint32_t v = 0; v < 256; v++) {
+        legacy_encode8(v, a);
+        pli_hex_encode8(v, b);
+        if (memcmp(a, b, 2) != 0) fail("encode8 " + std::to_string(v));
+    }
+    for (uint32_t v = 0; v < 65536; v++) {
+        legacy_encode16(v, a);
+        pli_hex_encode16(v, b);
+        if (memcmp(a, b, 4) != 0) fail("encode16 " + std::to_string(v));
+        // jede Hälfte mit allen Werten, die Hälften werden unabhängig kodiert
+        for (uint32_t w : {v << 16 | (~v & 0xffff), (v * 0x9e37u) << 16 | v}) {
+            legacy_encode32(w, a);
+            pli_hex_encode32(w, b);
+            if (memcmp(a, b, 8) != 0) fail("encode32 " + std::to_string(w));
+            if (!pli_hex_decode(b, 8, &vb) || vb != w) fail("decode 8 digits " + std::string(b));
+        }
+        if (!pli_hex_decode(b, 4, &vb) || vb != (v * 0x9e37u & 0xffff)) fail("decode 4 digits " + std::string(b));
+    }
+    // alle Zeichenpaare, gültig oder nicht
+    for (int c0 = 1; c0 < 256; c0++) {
+        for (int c1 = 1; c1 < 256; c1++) {
+            char text[3] = {char(c0), char(c1), 0};
+            for (int digits : {1, 2}) {
+                int la = legacy_from_hex(text, &va, digits), lb = pli_hex_decode(text, digits, &vb);
+                if (la != lb || (la && va != vb)) fail("from_hex " + std::string(text));
+                la = legacy_from_dec(text, &va, digits), lb = pli_dec_decode(text, digits, &vb);
+                if (la != lb || (la && va != vb)) fail("from_dec " + std::string(text));
+            }
+        }
+    }
+    for (uint32_t v = 0; v < 10000; v++) {
+        char text[5];
+        snprintf(text, sizeof(text), "%04u", v);
+        if (!pli_dec_decode(text, 4, &vb) || vb != v) fail("dec " + std::string(text));
+    }
+}
+
+static void bench_codec() {
+    char text[16];
+
+    measure("plib/encode8", "legacy", 256, [&](long n) {
+        for (long i = 0; i < n; i++)
+            for (int v = 0; v < 256; v++) legacy_encode8(static_cast<uint8_t>(v), text);
+        sink = text[0];
+    });
+    measure("plib/encode8", "", 256, [&](long n) {
+        for (long i = 0; i < n; i++)
+            for (int v = 0; v < 256; v++) pli_hex_encode8(static_cast<uint8_t>(v), text);
+        sink = text[0];
+    });
+    measure("plib/encode16", "legacy", 256, [&](long n) {
+        for (long i = 0; i < n; i++)
+            for (int v = 0; v < 256; v++) legacy_encode16(static_cast<uint16_t>(v * 257), text);
+        sink = text[0];
+    });
+    measure("plib/encode16", "", 256, [&](long n) {
+        for (long i = 0; i < n; i++)
+            for (int v = 0; v < 256; v++) pli_hex_encode16(static_cast<uint16_t>(v * 257), text);
+        sink = text[0];
+    });
+    measure("plib/encode32", "legacy", 256, [&](long n) {
+        for (long i = 0; i < n; i++)
+            for (uint32_t v = 0; v < 256; v++) legacy_encode32(v * 0x01010101u, text);
+        sink = text[0];
+    });
+    measure("plib/encode32", "", 256, [&](long n) {
+        for (long i = 0; i < n; i++)
+            for (uint32_t v = 0; v < 256; v++) pli_hex_encode32(v * 0x01010101u, text);
+        sink = text[0];
+    });
+
+    for (int digits : {2, 4, 8}) {
+        char hex[] = "a5c3f01e";
+        measure("plib/from_hex", "legacy digits=" + std::to_string(digits), 1, [&](long n) {
+            uint32_t v = 0;
+            for (long i = 0; i < n; i++) legacy_from_hex(hex, &v, digits);
+            sink = v;
+        });
+        measure("plib/from_hex", "digits=" + std::to_string(digits), 1, [&](long n) {
+            uint32_t v = 0;
+            for (long i = 0; i < n; i++) pli_hex_decode(hex, digits, &v);
+            sink = v;
+        });
+    }
+    for (int digits : {2, 4}) {
+        char dec[] = "2025";
+        measure("plib/from_dec", "legacy digits=" + std::to_string(digits), 1, [&](long n) {
+            uint32_t v = 0;
+            for (long i = 0; i < n; i++) legacy_from_dec(dec, &v, digits);
+            sink = v;
+        });
+        measure("plib/from_dec", "digits=" + std::to_string(digits), 1, [&](long n) {
+            uint32_t v = 0;
+            for (long i = 0; i < n; i++) pli_dec_decode(dec, digits, &v);
+            sink = v;
+        });
+    }
+}
+
+static void bench_protocol() {
+    // typische Nachrichten vom PC: Schalter, ADC, Zeit, Abfrage
+    const char *messages[] = {"d01a5", "d0a03ff", "dT20250102030405", "?S"};
+    for (const char *m : messages) {
+        char msg[40];
+        measure("plib/incoming_from_visu", m, 1, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                strcpy(msg, m); // wird beim Parsen nicht verändert, aber ist kein const char*
+                bench_incoming_from_visu(msg);
+            }
+        });
+    }
+}
+
+// pl_do(): wie viele Aufrufe ein Burst braucht und wie lange ein Aufruf
+// höchstens dauert, bisher 1 Byte pro Aufruf (Budget 1)
+static void bench_do() {
+    std::string burst;
+    for (int i = 0; i < 5; i++) burst += "d0a03ff\n";         // 40 Bytes
+    std::string full;
+    while (full.size() + 8 <= 256) full += "d0a03ff\n";      // volle Queue
+
+    for (uint16_t bytes : {1, 16, 64}) {
+        bench_pl_do_budget(bytes, 0);
+        bench_plib_feed(reinterpret_cast<const uint8_t *>(burst.data()), burst.size());
+        int calls = 0, handled = 0;
+        while (bench_plib_pending()) {
+            handled += bench_pl_do();
+            calls++;
+        }
+        if (handled != 5) {
+            std::cerr << "pl_do: " << handled << " of 5 messages handled" << std::endl;
+            exit(2);
+        }
+        std::string param = "budget=" + std::to_string(bytes);
+        measure("plib/pl_do_burst", param, 1, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                bench_plib_feed(reinterpret_cast<const uint8_t *>(burst.data()), burst.size());
+                while (bench_plib_pending()) bench_pl_do();
+            }
+        });
+
+        // längster einzelner Aufruf bei voller Queue: pro Aufruf die beste von
+        // 2000 Wiederholungen (gegen Störungen durch das System), davon das Maximum
+        using clock = std::chrono::steady_clock;
+        std::vector<double> call_ns;
+        for (int i = 0; i < 2000; i++) {
+            bench_plib_feed(reinterpret_cast<const uint8_t *>(full.data()), full.size());
+            for (size_t k = 0; bench_plib_pending(); k++) {
+                auto start = clock::now();
+                bench_pl_do();
+                double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+                if (k == call_ns.size()) call_ns.push_back(ns);
+                else call_ns[k] = std::min(call_ns[k], ns);
+            }
+        }
+        double worst = *std::max_element(call_ns.begin(), call_ns.end());
+        std::cerr << "plib/pl_do " << param << ": " << burst.size() / static_cast<double>(calls)
+                  << " bytes/call, " << calls << " calls per burst, longest call " << worst << " ns" << std::endl;
+    }
+
+    // Zeitbudget: kürzere Aufrufe auch bei großem Byte-Budget
+    bench_pl_do_budget(0xffff, 2000);
+    bench_plib_feed(reinterpret_cast<const uint8_t *>(full.data()), full.size());
+    int calls = 0;
+    while (bench_plib_pending()) {
+        bench_pl_do();
+        calls++;
+    }
+    std::cerr << "plib/pl_do cycles=2000 ns: " << calls << " calls for " << full.size() << " bytes" << std::endl;
+    bench_pl_do_budget(64, 0);
+}
+
+// Prüfung der Eingabe-Events: nur Änderungen, Flanken in pressed/released
+static void check_events() {
+    pl_event event;
+    char msg[16];
+    while (pl_event_get(&event)) {
+    }
+    for (const char *m : {"d0205", "d0205", "d0204", "d0a0100", "d0a0100"}) {
+        strcpy(msg, m);
+        bench_incoming_from_visu(msg);
+    }
+    const struct { uint8_t source, pressed, released; uint16_t value; } expected[] = {
+        {PL_EVENT_BUTTON, 0x05, 0x00, 0x05},
+        {PL_EVENT_BUTTON, 0x00, 0x01, 0x04},
+        {PL_EVENT_ADC, 0x00, 0x00, 0x100},
+    };
+    for (const auto &e : expected) {
+        if (!pl_event_get(&event) || event.source != e.source || event.pressed != e.pressed
+                || event.released != e.released || event.value != e.value) {
+            std::cerr << "pl_event: wrong or missing event" << std::endl;
+            exit(2);
+        }
+    }
+    if (pl_event_get(&event)) {
+        std::cerr << "pl_event: event without change" << std::endl;
+        exit(2);
+    }
+    strcpy(msg, "d0200");
+    bench_incoming_from_visu(msg);
+    strcpy(msg, "d0a0000");
+    bench_incoming_from_visu(msg);
+    while (pl_event_get(&event)) {
+    }
+}
+
+// Schattenwerte: Regelschleife mit 1 kHz, gesendet wird nur 25 mal pro Sekunde
+static void check_shadows() {
+    uint8_t wire[256];
+    pl_flush();
+    bench_plib_take(wire, sizeof(wire));
+    for (uint16_t interval : {0, 40}) {
+        pl_flush_interval(interval);
+        size_t before = bench_plib_sent();
+        for (int t = 1; t <= 1000; t++) {
+            pl_tick();
+            if (t == 1000)
+                bench_plib_take(wire, sizeof(wire)); // nur der Rest interessiert
+            pl_seesaw_display(0.25f, t / 2000.0f, 0.01f, 0);
+            bench_pl_do();
+        }
+        pl_flush();
+        size_t n = bench_plib_take(wire, sizeof(wire));
+        size_t total = bench_plib_sent() - before;
+        std::cerr << "plib/seesaw 1000 Hz interval=" << interval << ": " << total << " bytes per second"
+                  << std::endl;
+        // der letzte Wert muss angekommen sein
+        char last[14];
+        int16_t position = 1000 / 2000.0f * 50000;
+        pli_hex_encode16((uint16_t) position, last);
+        last[4] = 0;
+        std::string tail(reinterpret_cast<char *>(wire), n);
+        if (n == 0 || tail.find(last) == std::string::npos) {
+            std::cerr << "pl_seesaw_display: latest value not sent" << std::endl;
+            exit(2);
+        }
+    }
+    pl_flush_interval(40);
+}
+
+// Telemetrie: Blöcke prüfen, Bytes pro Abtastwert und Abtastwerte pro Sekunde je Baudrate
+static void check_telemetry() {
+    uint8_t wire[256];
+    pl_telemetry_channel(0, PL_TELEMETRY_FLOAT, "angle");
+    pl_telemetry_channel(1, PL_TELEMETRY_INT16, "pwm");
+    pl_telemetry_channel(2, PL_TELEMETRY_UINT16, "adc");
+    pl_flush();
+    bench_plib_take(wire, sizeof(wire));
+
+    // Blöcke als Text: Folge 00, 975 (0x3cf) verworfen, dann je Zeit, 1.0f, -2, 1000
+    const float one[] = {1.0f, -2.0f, 1000.0f};
+    for (int i = 0; i < 1000; i++)
+        pl_telemetry_sample(one); // 25 passen in den Puffer, der Rest wird verworfen
+    pl_flush();
+    std::string text(reinterpret_cast<char *>(wire), bench_plib_take(wire, sizeof(wire)));
+    if (text.compare(0, 8, "dY0003cf") != 0 || text.find("3f800000fffe03e8\n") == std::string::npos) {
+        std::cerr << "pl_telemetry: wrong block " << text << std::endl;
+        exit(2);
+    }
+    pl_telemetry_decimation(4);
+    int kept = 0;
+    for (int i = 0; i < 8; i++)
+        kept += pl_telemetry_sample(one) == 1;
+    pl_telemetry_decimation(1);
+    if (kept != 2) {
+        std::cerr << "pl_telemetry: decimation keeps " << kept << " of 8" << std::endl;
+        exit(2);
+    }
+    pl_flush();
+    bench_plib_take(wire, sizeof(wire));
+
+    for (int framed : {0, 1}) {
+        bench_plib_frames(framed);
+        size_t before = bench_plib_sent();
+        const int samples = 1000;
+        for (int t = 0; t < samples; t++) {
+            const float values[] = {t * 0.001f, float(t % 200 - 100), float(t & 1023)};
+            pl_tick();
+            if (pl_telemetry_sample(values) != 1) {
+                std::cerr << "pl_telemetry: sample dropped" << std::endl;
+                exit(2);
+            }
+            bench_pl_do();
+        }
+        pl_flush();
+        double per_sample = double(bench_plib_sent() - before) / samples;
+        std::cerr << "plib/telemetry 3 channels " << (framed ? "framed" : "hex") << ": " << per_sample
+                  << " bytes/sample";
+        for (uint32_t baud : {9600, 115200, 921600})
+            std::cerr << ", " << baud << " baud " << int(baud / 10 / per_sample) << "/s";
+        std::cerr << std::endl;
+    }
+    bench_plib_frames(0);
+    bench_plib_take(wire, sizeof(wire));
+
+    const float values[] = {0.5f, 10.0f, 512.0f};
+    measure("plib/pl_telemetry_sample", "channels=3", 1, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            pl_telemetry_sample(values);
+            if ((i & 15) == 15)
+                pl_flush();
+        }
+        bench_plib_take(wire, sizeof(wire));
+    });
+}
+
+// Profiling-Zonen: Statistik prüfen und den Aufwand einer leeren Zone messen
+static void check_profile() {
+    uint8_t wire[256];
+    bench_plib_take(wire, sizeof(wire));
+    for (int i = 0; i < 1000; i++) {
+        PL_PROFILE_BEGIN(bench_zone);
+        for (int k = 0; k < 100; k++)
+            sink = k;
+        PL_PROFILE_END(bench_zone);
+    }
+    pl_profile_report();
+    std::string report(reinterpret_cast<char *>(wire), bench_plib_take(wire, sizeof(wire)));
+    if (report.compare(0, 24, "dDbench_zone n=1000 min=") != 0) {
+        std::cerr << "pl_profile: wrong report " << report << std::endl;
+        exit(2);
+    }
+    std::cerr << "plib/profile " << report.substr(2);
+    pl_profile_reset();
+    // ein langer Name wird abgeschnitten statt über die Zeile hinaus geschrieben
+    PL_PROFILE_BEGIN(a_zone_with_a_very_long_name_that_alone_fills_most_of_the_report_line_of_pl_profile_report_and_leaves_no_room_for_the_numbers_and_the_histogram_behind_it);
+    PL_PROFILE_END(a_zone_with_a_very_long_name_that_alone_fills_most_of_the_report_line_of_pl_profile_report_and_leaves_no_room_for_the_numbers_and_the_histogram_behind_it);
+    pl_profile_report();
+    report.assign(reinterpret_cast<char *>(wire), bench_plib_take(wire, sizeof(wire)));
+    if (report.size() != 2 + 159 + 1 || report.compare(0, 8, "dDa_zone") != 0) {
+        std::cerr << "pl_profile: long name reported as " << report << std::endl;
+        exit(2);
+    }
+    pl_profile_reset();
+    measure("plib/profile_zone", "empty", 1, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            PL_PROFILE_BEGIN(empty);
+            PL_PROFILE_END(empty);
+        }
+    });
+    pl_profile_reset();
+}
+
+// Link-Statistik: Fehler je Fehlercode, Antwort auf ?Q und ?q
+static void check_link_statistics() {
+    uint8_t wire[256];
+    char msg[16];
+    pl_link_statistics before, after;
+    pl_link_statistics_get(&before);
+    for (const char *m : {"dZ", "d1", "?Q", "?q"}) {
+        strcpy(msg, m);
+        bench_incoming_from_visu(msg);
+    }
+    pl_link_statistics_get(&after);
+    std::string answer(reinterpret_cast<char *>(wire), bench_plib_take(wire, sizeof(wire)));
+    // dZ: unbekanntes Item (e03), d1: zu kurz für den Bildschirm (e03 oder e04)
+    uint32_t errors = 0;
+    for (int i = 0; i < PL_LINK_ERROR_CODES; i++)
+        errors += after.errors[i] - before.errors[i];
+    size_t q = answer.find("dQ"), p = answer.find("dq");
+    if (errors != 2 || q == std::string::npos || p == std::string::npos
+            || answer.find('\n', q) - q != 2 + 64 || answer.find('\n', p) - p != 2 + 80) {
+        std::cerr << "pl_link_statistics: " << errors << " errors, answer " << answer << std::endl;
+        exit(2);
+    }
+}
+
+// Timer: Reihenfolge, Perioden, verpasste Perioden und Stopp mit simuliertem Tick
+static std::vector<std::pair<uint32_t, int>> timer_runs;
+
+static void on_timer(pl_timer *timer) {
+    timer_runs.push_back({pl_ticks(), int(reinterpret_cast<intptr_t>(timer->context))});
+}
+
+static void on_timer_stop(pl_timer *timer) {
+    on_timer(timer);
+    if (timer_runs.size() >= 3)
+        pl_timer_stop(timer);
+}
+
+static void check_timers() {
+    pl_timer timers[PL_TIMERS + 1];
+    memset(timers, 0x55, sizeof(timers)); // nie gestartete Timer dürfen beliebigen Inhalt haben
+    for (int i = 0; i <= PL_TIMERS; i++)
+        timers[i].context = reinterpret_cast<void *>(intptr_t(i));
+    auto fail = [](const std::string &what) {
+        std::cerr << "pl_timer: " << what << std::endl;
+        exit(2);
+    };
+
+    uint32_t start = pl_ticks();
+    pl_timer_start(&timers[0], 5, 0, on_timer);
+    pl_timer_start(&timers[1], 10, 10, on_timer);
+    pl_timer_start(&timers[2], 0, 3, on_timer);
+    for (int t = 0; t < 100; t++) {
+        bench_pl_do();
+        pl_tick();
+    }
+    int count[3] = {0, 0, 0};
+    for (size_t i = 0; i < timer_runs.size(); i++) {
+        uint32_t late = timer_runs[i].first - start;
+        int id = timer_runs[i].second;
+        count[id]++;
+        if ((id == 0 && late != 5) || (id != 0 && late % (id == 1 ? 10 : 3) != 0))
+            fail("timer " + std::to_string(id) + " ran at " + std::to_string(late));
+        if (i > 0 && timer_runs[i].first < timer_runs[i - 1].first)
+            fail("not in order of due time");
+    }
+    if (count[0] != 1 || count[1] != 9 || count[2] != 34 || pl_timer_started(&timers[0]))
+        fail("runs " + std::to_string(count[0]) + " " + std::to_string(count[1]) + " " + std::to_string(count[2]));
+    pl_timer_stop(&timers[2]);
+
+    // pl_do() kommt 25 Ticks zu spät: einmal ausführen, zwei Perioden verpasst, Raster bleibt
+    bench_pl_do();
+    timer_runs.clear();
+    uint32_t due = timers[1].due;
+    while (pl_ticks() != due + 25)
+        pl_tick();
+    bench_pl_do();
+    if (timer_runs.size() != 1 || timers[1].misses != 2 || timers[1].late_max != 25
+            || timers[1].due != due + 30)
+        fail("misses " + std::to_string(timers[1].misses) + " late " + std::to_string(timers[1].late_max));
+    pl_timer_stop(&timers[1]);
+
+    // Stopp aus dem eigenen Handler, volle Warteschlange
+    timer_runs.clear();
+    pl_timer_start(&timers[3], 1, 1, on_timer_stop);
+    for (int t = 0; t < 10; t++) {
+        pl_tick();
+        bench_pl_do();
+    }
+    if (timer_runs.size() != 3 || pl_timer_started(&timers[3]))
+        fail("stop in handler, " + std::to_string(timer_runs.size()) + " runs");
+    for (int i = 0; i < PL_TIMERS; i++)
+        if (pl_timer_start(&timers[i], 1000 + i, 0, on_timer) != 1)
+            fail("start " + std::to_string(i));
+    if (pl_timer_start(&timers[PL_TIMERS], 1, 0, on_timer) != -1)
+        fail("more than PL_TIMERS started");
+
+    // Aufwand: Start und Stopp bei voller Warteschlange, pl_do() ohne fällige Timer
+    pl_timer_stop(&timers[PL_TIMERS / 2]);
+    measure("plib/pl_timer_start_stop", "timers=" + std::to_string(PL_TIMERS), 1, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            pl_timer_start(&timers[PL_TIMERS / 2], 500 + (i & 1023), 0, on_timer);
+            pl_timer_stop(&timers[PL_TIMERS / 2]);
+        }
+    });
+    measure("plib/pl_do", "timers=" + std::to_string(PL_TIMERS - 1) + " idle", 1, [&](long n) {
+        for (long i = 0; i < n; i++)
+            bench_pl_do();
+    });
+    for (int i = 0; i < PL_TIMERS; i++)
+        pl_timer_stop(&timers[i]);
+    timer_runs.clear();
+}
+
+// Kalender: Schaltjahre, Monatswechsel, Wochentag, Setzen mit 'T' und Kosten von pl_time_get()
+static void check_date() {
+    auto fail = [](const std::string &what) {
+        std::cerr << "plib/date: " << what << std::endl;
+        exit(2);
+    };
+    if (pli_days_of_month(2000, 2) != 29 || pli_days_of_month(2100, 2) != 28
+            || pli_days_of_month(2024, 2) != 29 || pli_days_of_month(2023, 2) != 28
+            || pli_days_of_month(2023, 4) != 30 || pli_days_of_month(2023, 12) != 31)
+        fail("days of month");
+
+    // jeder Tag von 2000 bis 2099 folgt auf den vorigen, Monat erst nach 12 zurück auf 1
+    pl_time expected = {2000, 1, 1, 0, 0, 0, 0}, t;
+    for (uint32_t day = 0; expected.year < 2100; day++) {
+        pli_date_from_seconds(day * 86400 + 86399, &t);
+        if (t.year != expected.year || t.month != expected.month || t.day != expected.day
+                || t.hour != 23 || t.min != 59 || t.sec != 59 || pli_date_to_seconds(&t) != day * 86400 + 86399)
+            fail("day " + std::to_string(day) + " is " + std::to_string(t.year) + "-" + std::to_string(t.month)
+                 + "-" + std::to_string(t.day));
+        if (++expected.day > pli_days_of_month(expected.year, expected.month)) {
+            expected.day = 1;
+            if (++expected.month > 12) {
+                expected.month = 1;
+                expected.year++;
+            }
+        }
+    }
+    pl_time monday = {2024, 1, 1, 0, 0, 0, 0}, saturday = {2000, 1, 1, 0, 0, 0, 0};
+    if (pli_date_weekday(&monday) != 1 || pli_date_weekday(&saturday) != 6)
+        fail("weekday");
+
+    // Mitternacht war bisher ungültig, der 29. Februar 2023 gültig
+    uint8_t wire[64];
+    char msg[32];
+    bench_plib_take(wire, sizeof(wire));
+    strcpy(msg, "dT20240229000000");
+    bench_incoming_from_visu(msg);
+    pl_time_get(&t);
+    pl_time set = {2024, 2, 29, 0, 0, 0, 0};
+    if (bench_plib_take(wire, sizeof(wire)) != 0 || pli_date_to_seconds(&t) - pli_date_to_seconds(&set) > 1)
+        fail("dT20240229000000 not set");
+    strcpy(msg, "dT20230229120000");
+    bench_incoming_from_visu(msg);
+    std::string answer(reinterpret_cast<char *>(wire), bench_plib_take(wire, sizeof(wire)));
+    if (answer.compare(0, 3, "e06") != 0)
+        fail("dT20230229120000 answered " + answer);
+
+    measure("plib/pl_time_get", "", 1, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            pl_time_get(&t);
+            sink = t.sec;
+        }
+    });
+}
+
+// Items: registrierte Handler, Dekodierung nach Typ, Fehlercodes und Kapazität
+static pl_item_value item_received;
+
+static int on_item(uint8_t, char, const pl_item_value *value) {
+    item_received = *value;
+    return PL_ITEM_OK;
+}
+
+static int on_item_range(uint8_t, char, const pl_item_value *value) {
+    return value->number > 100 ? PL_ITEM_VALUE : PL_ITEM_OK;
+}
+
+// gibt beliebige Werte zurück, auch solche ohne pl_item_result
+static int on_item_any(uint8_t, char, const pl_item_value *value) {
+    return int(value->number) - 2;
+}
+
+static void check_items() {
+    auto fail = [](const std::string &what) {
+        std::cerr << "pl_item: " << what << std::endl;
+        exit(2);
+    };
+    uint8_t wire[64];
+    char msg[32];
+    auto answer = [&](const char *m) {
+        strcpy(msg, m);
+        bench_incoming_from_visu(msg);
+        return std::string(reinterpret_cast<char *>(wire), bench_plib_take(wire, sizeof(wire)));
+    };
+    bench_plib_take(wire, sizeof(wire));
+    if (pl_item_register(2, 'k', PL_ITEM_HEX16, on_item) != 1
+            || pl_item_register(2, 'r', PL_ITEM_DEC, on_item_range) != 1
+            || pl_item_register(2, 'o', PL_ITEM_DEC, on_item_any) != 1
+            || pl_item_register(PL_SCREEN_NONE + 1, 'k', PL_ITEM_HEX8, on_item) != -1
+            || pl_item_register(2, '-', PL_ITEM_HEX8, on_item) != -1
+            || pl_item_register(2, 'k', PL_ITEM_TEXT + 1, on_item) != -1)
+        fail("register");
+    if (answer("d2k12af") != "" || item_received.number != 0x12af || item_received.len != 4)
+        fail("d2k12af");
+    const std::pair<const char *, const char *> errors[] = {
+        {"d3k1234", "e02"}, {"d2x1234", "e03"}, {"d2", "e03"}, {"d2k123", "e04"},
+        {"d2k12g4", "e05"}, {"d2r101", "e06"}, {"d2r100", ""}, {"d0112", ""},
+        {"d2o6", "e06"}, {"d2o7", "e06"}, {"d2o1", "e06"}, {"d2o0", "e06"}, {"d2o3", "e04"}};
+    for (auto [m, e] : errors) {
+        std::string a = answer(m);
+        if (a.compare(0, 3, e) != 0 || (!*e && !a.empty()))
+            fail(std::string(m) + " answered " + a);
+    }
+    // plib selbst: 7 Items (Schalter, Taster, 2 ADCs, T, B, V), 3 von oben
+    int more = 0;
+    for (char c = '0'; c <= '9' && pl_item_register(9, c, PL_ITEM_HEX8, on_item) == 1; c++)
+        more++;
+    for (char c = 'a'; c <= 'z' && pl_item_register(9, c, PL_ITEM_HEX8, on_item) == 1; c++)
+        more++;
+    if (more != PL_ITEMS - 10 || pl_item_register(9, '0', PL_ITEM_HEX8, nullptr) != 1
+            || answer("d9000").compare(0, 3, "e03") != 0 || pl_item_register(9, '0', PL_ITEM_HEX8, on_item) != 1)
+        fail("capacity " + std::to_string(more));
+}
+
+// Credits: plib gewährt nach 'dV...c' den Rx-Puffer und meldet gelesene Bytes ab halbem Puffer nach
+static void check_credits() {
+    uint8_t wire[256];
+    auto feed = [&](const std::string &in) {
+        bench_plib_feed(reinterpret_cast<const uint8_t *>(in.data()), in.size());
+        while (bench_plib_pending())
+            bench_pl_do();
+        std::string out(reinterpret_cast<char *>(wire), bench_plib_take(wire, sizeof(wire)));
+        size_t c = out.find("dC");
+        return c == std::string::npos ? std::string() : out.substr(c, 7);
+    };
+    auto fail = [](const std::string &what) {
+        std::cerr << "credits: " << what << std::endl;
+        exit(2);
+    };
+    bench_plib_frames(0);
+    bench_plib_take(wire, sizeof(wire));
+    // genug Nachrichten für einen halben Puffer
+    std::string c, six = "d0112\n", half;
+    while (half.size() < PL_RX_BUFFER_LEN / 2)
+        half += six;
+    char expected[8];
+    snprintf(expected, sizeof(expected), "dC%04x\n", PL_RX_BUFFER_LEN);
+    if ((c = feed("dV03c0\n")) != expected)
+        fail("dV03c0 granted " + c);
+    // pl_do() liest PL_DO_BYTES je Aufruf, gewährt wird nach dem halben Puffer
+    c = feed(half);
+    unsigned long limit = c.size() == 7 ? strtoul(c.c_str() + 2, nullptr, 16) : 0;
+    if (limit < PL_RX_BUFFER_LEN + PL_RX_BUFFER_LEN / 2 || limit > PL_RX_BUFFER_LEN + half.size())
+        fail(std::to_string(half.size()) + " bytes granted " + c);
+    if ((c = feed(six)) != "")
+        fail("6 bytes granted " + c);
+    // ohne 'c' wieder ohne Credits
+    if ((c = feed("dV030\n")) != "" || (c = feed(half)) != "")
+        fail("dV030 granted " + c);
+}
+
+// printf-Ausgabe: zeilenweise als Log, ohne Warten auf den Tx-Puffer, ganze Writes verworfen und gezählt
+static void check_stdout() {
+    uint8_t wire[512];
+    auto fail = [](const std::string &what) {
+        std::cerr << "pl_stdout_write: " << what << std::endl;
+        exit(2);
+    };
+    auto write = [](const std::string &text) { return pl_stdout_write(text.data(), text.size()); };
+    int framed = 0;
+    auto drain = [&]() {
+        bench_pl_do();
+        std::string out(reinterpret_cast<char *>(wire), bench_plib_take(wire, sizeof(wire)));
+        if (!framed)
+            return out;
+        // Frames zurück in Textzeilen (Typ 0x80: Text, SLIP-Escapes, 2 Bytes CRC)
+        std::string lines, frame;
+        for (size_t i = 0; i < out.size(); i++) {
+            uint8_t c = out[i];
+            if (c == PLI_FRAME_END) {
+                if (frame.size() < 3 || uint8_t(frame[0]) != PLI_FRAME_TEXT)
+                    return std::string("bad frame");
+                lines += frame.substr(1, frame.size() - 3) + "\n";
+                frame.clear();
+            } else if (c == PLI_FRAME_ESC && i + 1 < out.size()) {
+                frame += uint8_t(out[++i]) == PLI_FRAME_ESC_END ? char(PLI_FRAME_END) : char(PLI_FRAME_ESC);
+            } else {
+                frame += char(c);
+            }
+        }
+        return lines;
+    };
+    // die längste Zeile passt auch als Frame mit lauter Escapes in den Tx-Puffer
+    const size_t line_max = std::min<size_t>(64, (PL_TX_BUFFER_LEN - 1) / 2 - 5);
+    bench_plib_tx_space(PL_TX_BUFFER_LEN);
+    for (framed = 0; framed < 2; framed++) {
+        bench_plib_frames(framed);
+        bench_plib_take(wire, sizeof(wire));
+        std::string out, mode = framed ? " (framed)" : "";
+        write("hello\r\nwor");
+        if ((out = drain()) != "dLhello\n")
+            fail("hello answered " + out + mode);
+        write("ld\n" + std::string(100, 'x') + "\n");
+        if ((out = drain()) != "dLworld\ndL" + std::string(line_max, 'x') + "\ndL"
+                + std::string(100 - line_max, 'x') + "\n")
+            fail("long line answered " + out + mode);
+        // Link voll: pl_do() wartet nicht, die Zeile kommt später
+        bench_plib_tx_space(4);
+        write("later\n");
+        if ((out = drain()) != "")
+            fail("full link answered " + out + mode);
+        bench_plib_tx_space(PL_TX_BUFFER_LEN);
+        if ((out = drain()) != "dLlater\n")
+            fail("later answered " + out + mode);
+    }
+    bench_plib_frames(0);
+    bench_plib_take(wire, sizeof(wire));
+    pl_link_statistics before, after;
+    pl_link_statistics_get(&before);
+    std::string fill(PL_STDOUT_BUFFER_LEN - 10, 'y');
+    if (write(fill) != int(fill.size()) || write("0123456789a\n") != 0)
+        fail("no drop");
+    pl_link_statistics_get(&after);
+    if (after.stdout_drops - before.stdout_drops != 12)
+        fail("drops " + std::to_string(after.stdout_drops - before.stdout_drops));
+    for (int i = 0; i < 8; i++)
+        drain();
+    write("\n");
+    drain();
+
+    const std::string line = "control loop: e=-0.0123 u=0.4567\n";
+    char log_line[64];
+    measure("plib/log line", "pl_log", 1, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            memcpy(log_line, line.data(), line.size() - 1);
+            log_line[line.size() - 1] = 0;
+            pl_log(log_line);
+            bench_plib_take(wire, sizeof(wire));
+        }
+    });
+    measure("plib/log line", "pl_stdout_write", 1, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            write(line);
+            bench_pl_do();
+            bench_plib_take(wire, sizeof(wire));
+        }
+    });
+    drain();
+}
+
+// bisheriges Rauschen von pl_adc_get(): LCG in double, zum Vergleich
+static int legacy_adc_get(uint16_t adc) {
+    const unsigned long a = 65539;
+    const unsigned long m = 2147483647;
+    static unsigned long xi = 7;
+    xi = (a * xi) % m;
+    int v = (double) xi / (double) m * 7.0 - 3.5;
+    v += adc;
+    return v < 0 ? 0 : v > 1023 ? 1023 : v;
+}
+
+// ADC-Rauschen: Mittelwert, Streuung und Grenzen je Verteilung, Kosten pro pl_adc_get()
+static void check_adc_noise() {
+    const int32_t amplitude = 896; // 3,5 Stufen
+    const struct {
+        uint8_t distribution;
+        const char *name;
+        double sigma; // erwartete Standardabweichung
+        int32_t limit;
+    } cases[] = {
+        {PL_ADC_NOISE_UNIFORM, "uniform", amplitude / std::sqrt(3.0), amplitude},
+        {PL_ADC_NOISE_TRIANGULAR, "triangular", amplitude / std::sqrt(6.0), amplitude},
+        {PL_ADC_NOISE_GAUSSIAN, "gaussian", double(amplitude), amplitude * 7 / 2},
+    };
+    for (const auto &c : cases) {
+        pli_noise noise;
+        pli_noise_init(&noise, c.distribution, amplitude);
+        const int n = 200000;
+        double sum = 0, squares = 0;
+        int32_t lowest = 0, highest = 0;
+        for (int i = 0; i < n; i++) {
+            int32_t v = pli_noise_next(&noise);
+            sum += v;
+            squares += double(v) * v;
+            lowest = std::min(lowest, v);
+            highest = std::max(highest, v);
+        }
+        double mean = sum / n, sigma = std::sqrt(squares / n - mean * mean);
+        std::cerr << "plib/adc_noise " << c.name << ": mean " << mean / 256 << " sigma " << sigma / 256
+                  << " range " << lowest / 256.0 << ".." << highest / 256.0 << " steps" << std::endl;
+        if (std::fabs(mean) > 10 || std::fabs(sigma / c.sigma - 1) > 0.03 || lowest < -c.limit
+                || highest > c.limit) {
+            std::cerr << "pl_adc_noise: " << c.name << " off" << std::endl;
+            exit(2);
+        }
+    }
+    if (pl_adc_noise(PL_ADC_NOISE_GAUSSIAN + 1, 0) != -1 || pl_adc_noise(PL_ADC_NOISE_UNIFORM, PL_ADC_NOISE_MAX + 1) != -1)
+        exit(2);
+
+    uint16_t value;
+    measure("plib/pl_adc_get", "legacy double", 1, [&](long n) {
+        for (long i = 0; i < n; i++)
+            sink = legacy_adc_get(512);
+    });
+    for (const auto &c : cases) {
+        pl_adc_noise(c.distribution, amplitude);
+        measure("plib/pl_adc_get", c.name, 1, [&](long n) {
+            for (long i = 0; i < n; i++) {
+                pl_adc_get(i & 1, &value);
+                sink = value;
+            }
+        });
+    }
+    pl_adc_noise(PL_ADC_NOISE_NONE, 0);
+    measure("plib/pl_adc_get", "none", 1, [&](long n) {
+        for (long i = 0; i < n; i++) {
+            pl_adc_get(i & 1, &value);
+            sink = value;
+        }
+    });
+    pl_adc_noise(PL_ADC_NOISE_UNIFORM, amplitude);
+}
+
+static void bench_app() {
+    measure("app/calc_display", "", 24 * 60, [&](long n) {
+        uint32_t v = 0;
+        for (long i = 0; i < n; i++)
+            for (uint8_t h = 0; h < 24; h++)
+                for (uint8_t m = 0; m < 60; m++) v ^= calc_display(h, m, m & 1, h & 1, false);
+        sink = v;
+    });
+}
+
+static void write_json(std::ostream &out) {
+    out << "{\n  \"min_time\": " << min_time << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"param\": \"" << r.param
+            << "\", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.ns_per_op << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char *argv[]) {
+    const char *output = nullptr;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:f:o:")) != -1) {
+        switch (opt) {
+        case 't': min_time = atof(optarg); break; // Sekunden pro Messung
+        case 'f': filter = optarg; break;         // z.B. -f service/
+        case 'o': output = optarg; break;         // JSON in Datei statt stdout
+        default:
+            std::cerr << "usage: " << argv[0] << " [-t seconds] [-f filter] [-o file.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    bench_service();
+    check_dictionary();
+    bench_websocket();
+    bench_queue();
+    bench_dma();
+    bench_dma_rx();
+    check_baud();
+    check_frames();
+    check_codec();
+    bench_codec();
+    check_events();
+    check_shadows();
+    check_telemetry();
+    check_profile();
+    check_link_statistics();
+    check_timers();
+    check_date();
+    check_adc_noise();
+    check_items();
+    check_credits();
+    check_stdout();
+    bench_protocol();
+    bench_do();
+    bench_app();
+
+    if (output) {
+        std::ofstream file(output);
+        write_json(file);
+    } else {
+        write_json(std::cout);
+    }
+    return 0;
+}
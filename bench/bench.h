@@ -0,0 +1,43 @@
+/*
+ * bench.h: entry points into the benchmarked modules
+ *
+ * The functions are thin wrappers around static functions of
+ * service.c (bench_service.c) and plibi_main.c (bench_plib.c).
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* game service, clients use file descriptors starting at BENCH_FIRST_FD */
+#define BENCH_FIRST_FD 1000
+
+void bench_service_populate(int clients);
+void bench_service_clear(void);
+int  bench_service_get(int fd);
+void bench_service_store_remove(int fd);
+int  bench_service_do(int fd);
+size_t bench_service_game(const char *guesses, char *out, size_t size);	/* one game, returns the output length */
+
+/* plib protocol */
+void bench_incoming_from_visu(char *msg);
+size_t bench_plib_sent(void);	/* bytes written to the serial stub */
+size_t bench_plib_take(uint8_t *data, size_t size);	/* bytes written since the last call */
+void bench_plib_feed(const uint8_t *data, size_t len);	/* bytes pl_do() receives next */
+size_t bench_plib_pending(void);
+int  bench_pl_do(void);
+void bench_pl_do_budget(uint16_t bytes, uint32_t cycles);
+void bench_plib_frames(int on);	/* send as after a negotiation of frames */
+void bench_plib_tx_space(int space);	/* room pl_do() sees in the tx buffer */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * bench_plib.c -- exposes the protocol internals of plibi_main.c
+ * to the benchmark, with the serial line replaced by a counter
+ */
+
+#include "plibi_main.c"
+
+#include <time.h>
+
+#include "bench.h"
+
+static size_t sent;
+static uint8_t written[256];	/* last bytes written, see bench_plib_take() */
+static size_t written_len;
+
+void pli_board_init(void)
+{
+}
+
+int pli_serial_init(uint32_t baud)
+{
+	(void) baud;
+	return 1;
+}
+
+void pli_serial_write(uint8_t data)
+{
+	sent++;
+	if (written_len < sizeof(written))
+		written[written_len++] = data;
+}
+
+static const uint8_t *received;	/* bytes for pli_serial_read(), see bench_plib_feed() */
+static size_t received_len;
+
+int pli_serial_read(uint8_t *data)
+{
+	return pli_serial_read_bulk(data, 1);
+}
+
+int pli_serial_read_bulk(uint8_t *data, int len)
+{
+	size_t n = received_len < (size_t) len ? received_len : (size_t) len;
+
+	memcpy(data, received, n);
+	received += n;
+	received_len -= n;
+	return n;
+}
+
+uint32_t pli_board_cycles(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t) (now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+static int tx_space = 128;	/* PL_TX_BUFFER_LEN, the stub sends at once */
+
+int pli_serial_tx_space(void)
+{
+	return tx_space;
+}
+
+void bench_plib_tx_space(int space)
+{
+	tx_space = space;
+}
+
+void pli_serial_counters_read(pli_serial_counters *counters)
+{
+	memset(counters, 0, sizeof(*counters));
+	counters->tx_bytes = sent;
+}
+
+#ifdef PL_QUEUE_STATISTICS
+void pli_serial_statistics_read(int *read, int *write)
+{
+	*read = 64;
+	*write = 128;
+}
+#endif
+
+int pli_serial_rx_pending(void)
+{
+	return received_len != 0;
+}
+
+void pli_board_sleep_begin(void)
+{
+}
+
+void pli_board_sleep(void)
+{
+}
+
+void pli_board_sleep_end(void)
+{
+}
+
+int pli_serial_baud_valid(uint32_t baud)
+{
+	(void) baud;
+	return 1;
+}
+
+int pli_serial_set_baud(uint32_t baud)
+{
+	(void) baud;
+	return 1;
+}
+
+void bench_incoming_from_visu(char *msg)
+{
+	state = 1;	/* as after pl_init(), replies are sent */
+	incoming_from_visu(msg, strlen(msg));
+}
+
+size_t bench_plib_sent(void)
+{
+	return sent;
+}
+
+size_t bench_plib_take(uint8_t *data, size_t size)
+{
+	size_t n = written_len < size ? written_len : size;
+
+	memcpy(data, written, n);
+	written_len = 0;
+	return n;
+}
+
+void bench_plib_feed(const uint8_t *data, size_t len)
+{
+	received = data;
+	received_len = len;
+}
+
+size_t bench_plib_pending(void)
+{
+	return received_len;
+}
+
+int bench_pl_do(void)
+{
+	state = 1;
+	return pl_do();
+}
+
+void bench_pl_do_budget(uint16_t bytes, uint32_t cycles)
+{
+	pl_do_budget(bytes, cycles);
+}
+
+void bench_plib_frames(int on)
+{
+	frames = on;
+}
@@ -0,0 +1,75 @@
+/*
+ * legacy_codec.c -- the hex and decimal conversions of plibi_main.c
+ * before plibi_codec.c, kept unchanged as benchmark baseline
+ */
+
+#include "legacy_codec.h"
+
+static char hex_digit(int digit) {
+	return digit <= 9 ? '0' + digit : 'a' + digit - 10;
+}
+
+void legacy_encode8(uint8_t s, char *d) {
+	// encode 8 bit to hex
+	*d++ = hex_digit(s >> 4);
+	*d++ = hex_digit(s & 0x0f);
+}
+
+void legacy_encode16(uint16_t s, char *d) {
+	// encode 16 bit to hex
+	for (int i = 0; i <= 1; i++) {
+		uint8_t b = s >> ((1 - i) * 8);
+		*d++ = hex_digit(b >> 4);
+		*d++ = hex_digit(b & 0x0f);
+	}
+}
+
+void legacy_encode32(uint32_t s, char *d) {
+	// encode 32 bit to hex
+	for (int i = 0; i <= 3; i++) {
+		uint8_t b = s >> ((3 - i) * 8);
+		*d++ = hex_digit(b >> 4);
+		*d++ = hex_digit(b & 0x0f);
+	}
+}
+
+int legacy_from_hex(char *text, uint32_t *out, int nr_digits) {
+	uint32_t value = 0;
+	int valid = 1;
+
+	while (nr_digits && valid) {
+		if (((*text >= '0') && (*text <= '9'))
+				|| ((*text >= 'a') && (*text <= 'f'))) {
+			value = (value << 4)
+					+ (*text <= '9' ? *text - '0' : *text - 'a' + 10);
+			nr_digits--;
+			text++;
+		} else
+			valid = 0;
+	}
+	if (valid) {
+		*out = value;
+		return 1;
+	} else
+		return 0;
+}
+
+int legacy_from_dec(char *text, uint32_t *out, int nr_digits) {
+	uint32_t value = 0;
+	int valid = 1;
+
+	while (nr_digits && valid) {
+		if ((*text >= '0') && (*text <= '9')) {
+
+			value = value * 10 + *text - '0';
+			nr_digits--;
+			text++;
+		} else
+			valid = 0;
+	}
+	if (valid) {
+		*out = value;
+		return 1;
+	} else
+		return 0;
+}
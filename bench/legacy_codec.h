@@ -0,0 +1,16 @@
+/*
+ * legacy_codec.h: baseline for the plib codec benchmarks
+ */
+
+#ifndef LEGACY_CODEC_H_
+#define LEGACY_CODEC_H_
+
+#include <stdint.h>
+
+void legacy_encode8(uint8_t s, char* d);
+void legacy_encode16(uint16_t s, char* d);
+void legacy_encode32(uint32_t s, char* d);
+int legacy_from_hex(char* text, uint32_t* out, int nr_digits);
+int legacy_from_dec(char* text, uint32_t* out, int nr_digits);
+
+#endif
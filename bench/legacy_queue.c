@@ -0,0 +1,66 @@
+/*
+ * legacy_queue.c -- the modulo based byte queue plib used before the
+ * SPSC ring in plibi_queue.c, kept unchanged as benchmark baseline
+ */
+
+#include "legacy_queue.h"
+
+
+#ifdef PL_QUEUE_STATISTICS
+int legacy_queue_statistics_free(legacy_queue* q){
+    int free=q->read - q->write - 1;
+    if (free < 0) free += q->size;
+    return free;
+}
+
+void legacy_queue_statistics_reset(legacy_queue* q){
+    q->min=q->size-1;
+}
+#endif
+
+void legacy_queue_init(legacy_queue* q, uint8_t* buffer, uint_fast16_t size)
+{
+    q->read = q->write = 0;
+    q->size = size;
+    q->buffer = buffer;
+#ifdef PL_QUEUE_STATISTICS
+    legacy_queue_statistics_reset(q);
+#endif
+}
+
+int legacy_queue_full(legacy_queue* q)
+{
+    return (((q->write + 1) % q->size) == q->read);
+}
+
+int legacy_queue_empty(legacy_queue* q)
+{
+    return (q->write == q->read);
+}
+
+int legacy_enqueue(legacy_queue* q, uint8_t data)
+{
+    if (legacy_queue_full(q))
+        return 0;
+    else {
+        q->buffer[q->write] = data;
+        q->write = ((q->write + 1) == q->size) ? 0 : q->write + 1;
+#ifdef PL_QUEUE_STATISTICS
+        uint_fast16_t min=legacy_queue_statistics_free(q);
+        if (min < q->min) q->min=min;
+#endif
+
+    }
+    return 1;
+}
+
+int legacy_dequeue(legacy_queue* q, uint8_t* data)
+{
+    if (legacy_queue_empty(q))
+        return 0;
+    else {
+        *data = q->buffer[q->read];
+        q->read = ((q->read + 1) == q->size) ? 0 : q->read + 1;
+    }
+    return 1;
+}
@@ -0,0 +1,37 @@
+/*
+ * legacy_queue.h: baseline for the plib queue benchmarks
+ */
+
+#ifndef LEGACY_QUEUE_H_
+#define LEGACY_QUEUE_H_
+
+#include <stdint.h>
+
+#include "plib_config.h"
+
+typedef struct legacy_queue {
+    uint_fast16_t read, write;
+    uint_fast16_t size;
+    uint8_t* buffer;
+#ifdef PL_QUEUE_STATISTICS
+    uint_fast16_t min;
+#endif
+} legacy_queue;
+
+#ifdef PL_QUEUE_STATISTICS
+int legacy_queue_statistics_free(legacy_queue* q);
+
+void legacy_queue_statistics_reset(legacy_queue* q);
+#endif
+
+void legacy_queue_init(legacy_queue* q, uint8_t* buffer, uint_fast16_t size);
+
+int legacy_queue_full(legacy_queue* q);
+
+int legacy_queue_empty(legacy_queue* q);
+
+int legacy_enqueue(legacy_queue* q, uint8_t data);
+
+int legacy_dequeue(legacy_queue* q, uint8_t* data);
+
+#endif